@@ -0,0 +1,26 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// A chunked bump allocator. Allocations are never freed one by one;
+// the whole arena is released at once with arena_reset or arena_destroy.
+// A zero-initialized Arena is ready to use.
+typedef struct ArenaChunk {
+    struct ArenaChunk* next;    // Previously filled chunk
+    size_t used;                // Bytes handed out from this chunk
+    size_t capacity;            // Usable bytes in data[]
+    _Alignas(max_align_t) unsigned char data[];  // Starts aligned like malloc's result
+} ArenaChunk;
+
+typedef struct {
+    ArenaChunk* head;           // Chunk currently being filled
+    size_t next_chunk_size;     // Capacity of the next chunk (grows geometrically)
+} Arena;
+
+// Arena operations.
+void* arena_alloc(Arena* arena, size_t size);
+void arena_reset(Arena* arena);    // Drop all allocations, keep one chunk for reuse
+void arena_destroy(Arena* arena);  // Release every chunk
+
+#endif /* ARENA_H */
@@ -0,0 +1,55 @@
+#ifndef AST_VISIT_H
+#define AST_VISIT_H
+
+#include "parser.h"
+
+// Generic preorder/postorder walk over an AST, driven by the ast_kinds
+// table: a node's children are the fields its kind lists, in the order
+// statement list, left, right, else_branch (the order print_ast shows).
+// The walk keeps its own stack, so it works on trees of any height.
+//
+// Several visitors can share one walk: each sees every node it has not
+// skipped, and all of them see a node before any of them sees the next.
+// Analyses that only need to look at nodes (not at one another's results)
+// can so be fused into a single pass over the tree.
+
+#define AST_MAX_VISITORS 8
+
+typedef enum {
+    AST_WALK_CONTINUE,        // Visit the node's children
+    AST_WALK_SKIP,            // Do not show this visitor the node's children
+    AST_WALK_STOP             // Show this visitor nothing more
+} AstWalkAction;
+
+// Field of the parent a node hangs from.
+typedef enum {
+    AST_FIELD_ROOT,
+    AST_FIELD_LIST,
+    AST_FIELD_LEFT,
+    AST_FIELD_RIGHT,
+    AST_FIELD_ELSE
+} AstField;
+
+typedef struct {
+    ASTNode* node;
+    ASTNode* parent;          // NULL for the root
+    AstField field;           // Where the parent holds node
+    int index;                // Position in the parent's statement list (AST_FIELD_LIST)
+    int depth;                // Edges from the root
+} AstVisit;
+
+typedef struct {
+    // Called before the node's children; NULL continues into them.
+    AstWalkAction (*enter)(const AstVisit* visit, void* context);
+    // Called after them, unless the visitor has stopped; may be NULL.
+    void (*leave)(const AstVisit* visit, void* context);
+    void* context;
+} AstVisitor;
+
+// Walk the tree under `root` (which may be NULL) with `count` visitors,
+// at most AST_MAX_VISITORS. Visitors may change the node they are given
+// but not its children fields. Returns 0 if the walk ran out of memory
+// for its stack, after visiting only part of the tree.
+int ast_walk(ASTNode* root, const AstVisitor* visitors, int count);
+
+#endif /* AST_VISIT_H */
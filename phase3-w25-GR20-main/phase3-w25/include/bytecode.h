@@ -0,0 +1,66 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "parser.h"
+#include "interpreter.h"
+
+// Stack-machine opcodes. Every instruction is one 32-bit word: the opcode
+// in the low 8 bits and a signed 24-bit operand (constant index, slot, or
+// jump offset relative to the next instruction) in the high 24 bits.
+typedef enum {
+    OP_CONST,           // push constants[arg]
+    OP_LOAD,            // push slots[arg]
+    OP_STORE,           // slots[arg] = pop
+    OP_CLEAR,           // slots[arg] = 0 (variable declaration)
+    OP_ADD,             // a b -> a + b
+    OP_SUB,
+    OP_MUL,
+    OP_DIV,
+    OP_LT,
+    OP_GT,
+    OP_LE,
+    OP_GE,
+    OP_EQ,
+    OP_NE,
+    OP_FACTORIAL,       // n -> factorial(n)
+    OP_PRINT,           // print pop
+    OP_POP,             // discard the top of the stack
+    OP_JUMP,            // pc += arg
+    OP_JUMP_IF_FALSE,   // if (!pop) pc += arg
+    OP_JUMP_IF_TRUE,    // if (pop) pc += arg
+    OP_HALT,
+    OP_COUNT
+} OpCode;
+
+#define BYTECODE_OP(word)   ((OpCode)((word) & 0xFF))
+#define BYTECODE_ARG(word)  ((int32_t)(word) >> 8)
+#define BYTECODE_ARG_MIN    (-(1 << 23))
+#define BYTECODE_ARG_MAX    ((1 << 23) - 1)
+
+// A compiled program: code, the line of each instruction (for runtime
+// errors), the constant pool and the frame/stack sizes the VM must reserve.
+typedef struct {
+    uint32_t *code;           // Instruction words
+    int *lines;               // Source line of each instruction
+    int count;                // Instructions in code[]
+    int capacity;
+    Value *constants;         // Constant pool (AST_NUMBER literals)
+    int constant_count;
+    int constant_capacity;
+    int slot_count;           // Variable slots (from analyze_semantics_slots)
+    int max_stack;            // Deepest operand stack the code can reach
+} Chunk;
+
+// Lower a program that analyze_semantics_slots accepted. Returns 1 on
+// success, 0 if memory ran out or an operand does not fit in 24 bits.
+int bytecode_compile(ASTNode *program, int slot_count, Chunk *chunk);
+void chunk_free(Chunk *chunk);
+void chunk_disassemble(const Chunk *chunk, FILE *out);
+
+// Execute a chunk. Uses threaded dispatch (computed goto) where the compiler
+// supports it. Returns 1 on success, 0 after printing a runtime error to out.
+int vm_run(const Chunk *chunk, FILE *out);
+
+#endif /* BYTECODE_H */
@@ -0,0 +1,40 @@
+#ifndef BYTECODE_CACHE_H
+#define BYTECODE_CACHE_H
+
+#include <stddef.h>
+#include "bytecode.h"
+#include "source.h"
+
+// On-disk cache of compiled programs. An entry lives at
+// <dir>/<content hash>.mbc and holds a versioned header, the bytecode
+// Chunk and the diagnostics the front end printed, so a hit can replace
+// lexing, parsing, semantic analysis and lowering entirely. Entries are
+// only written for sources that compiled without errors.
+
+// Bump whenever the bytecode, the lowering or the entry layout changes;
+// entries written by other versions are ignored.
+#define BYTECODE_CACHE_VERSION 1
+
+// A loaded entry. The chunk points into the read-only mapping of the
+// entry file (no copy is made); release it with bytecode_cache_close,
+// never chunk_free.
+typedef struct {
+    SourceFile file;          // Mapping of the entry
+    Chunk chunk;              // Views into file
+    int tokens;               // Tokens the source lexed to
+    const char* diagnostics;  // NUL-terminated front-end output (warnings)
+} CachedProgram;
+
+// 64-bit FNV-1a of the source text; entries are keyed by it.
+unsigned long long bytecode_cache_hash(const char* text, size_t size);
+
+// Load the entry for `source`. Returns 1 on a hit; 0 if there is no entry
+// or it has the wrong version, hash, size or shape.
+int bytecode_cache_load(const char* dir, const char* source, size_t size, CachedProgram* program);
+void bytecode_cache_close(CachedProgram* program);
+
+// Write the entry for `source` (atomically, via a rename). Returns 1 on success.
+int bytecode_cache_store(const char* dir, const char* source, size_t size,
+                         const Chunk* chunk, int tokens, const char* diagnostics);
+
+#endif /* BYTECODE_CACHE_H */
@@ -0,0 +1,69 @@
+#ifndef CFG_H
+#define CFG_H
+
+#include <stdint.h>
+#include "parser.h"
+
+// Control flow graph of a checked program, with bit-vector dataflow over
+// its variable slots. A basic block is a run of straight-line statements
+// (declarations, assignments, prints) followed by at most one branch
+// condition. A set of slots is `words` 64-bit words, so each transfer
+// function handles 64 variables per operation.
+//
+// Liveness is solved to a fixed point (backward, union over successors):
+// a slot is in live_out if some path from the end of the block reads it
+// before writing it. Backends use it to drop dead stores (see
+// fold_constants) and can use it to give slots that are never live
+// together one register. Uninitialized variables are not found here: the
+// checker tracks definite assignment structurally as it walks the tree
+// (see semantic.c), which on this language's if/while/repeat gives the
+// same answer without a graph.
+
+typedef uint64_t CfgWord;
+
+#define CFG_NONE (-1)              // No successor
+#define CFG_MAX_WORDS (1 << 22)    // Cap on the words of every set together (32 MB)
+
+typedef struct {
+    int first;                // Index of its first statement in Cfg.statements
+    int count;                // Straight-line statements in the block
+    ASTNode* condition;       // Branch evaluated after them (NULL = falls through)
+    int successors[2];        // Next block when the condition holds (or always); when not
+    CfgWord* live_out;        // Slots live on exit
+} CfgBlock;
+
+typedef struct {
+    CfgBlock* blocks;         // blocks[0] is the entry and the last block the exit
+    int block_count;
+    int block_capacity;
+    ASTNode** statements;     // Statements of every block, block after block
+    int statement_count;
+    int statement_capacity;
+    int slot_count;           // Bits per set
+    int words;                // CfgWord per set
+    CfgWord* bits;            // Storage for every set
+} Cfg;
+
+// Build the graph of `program` and solve liveness. The tree must have
+// been checked: every variable carries a slot below slot_count. Returns 0,
+// leaving *cfg empty, if memory runs out, a slot is out of range or the
+// sets would take more than CFG_MAX_WORDS.
+int cfg_build(ASTNode* program, int slot_count, Cfg* cfg);
+void cfg_free(Cfg* cfg);
+
+// Add the slots an expression (or a print or other statement) reads to `set`.
+void cfg_add_reads(const ASTNode* node, CfgWord* set);
+
+static inline int cfg_test(const CfgWord* set, int slot) {
+    return (int)((set[slot / 64] >> (slot % 64)) & 1);
+}
+
+static inline void cfg_set(CfgWord* set, int slot) {
+    set[slot / 64] |= (CfgWord)1 << (slot % 64);
+}
+
+static inline void cfg_clear(CfgWord* set, int slot) {
+    set[slot / 64] &= ~((CfgWord)1 << (slot % 64));
+}
+
+#endif /* CFG_H */
@@ -0,0 +1,16 @@
+#ifndef CODEGEN_H
+#define CODEGEN_H
+
+#include <stdio.h>
+#include "parser.h"
+
+// Native backend: lowers a checked (and optionally folded) AST to a
+// standalone C11 translation unit for the system compiler. Every variable
+// slot becomes a local of main, so the C compiler can keep it in a
+// register; factorial becomes a loop. The program prints exactly what the
+// interpreter and VM print, and reports division by zero the same way
+// (in its output, then exit status 1).
+// Returns 1 on success, 0 if the tree holds a node the backend cannot lower.
+int codegen_emit_c(ASTNode* program, int slot_count, FILE* out);
+
+#endif /* CODEGEN_H */
@@ -0,0 +1,56 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <stdio.h>
+
+// Structured diagnostics. The lexer, parser and checker record each error
+// as a plain record in a per-context DiagnosticList (no formatting, no
+// I/O); whoever owns the context prints the list afterwards with one of
+// the formatters, from its own thread and in a deterministic order.
+
+typedef enum {
+    DIAGNOSTIC_LEXICAL,       // code is an ErrorType
+    DIAGNOSTIC_SYNTAX,        // code is a ParseError
+    DIAGNOSTIC_SEMANTIC       // code is a SemanticErrorType
+} DiagnosticPhase;
+
+typedef struct {
+    DiagnosticPhase phase;
+    int code;                 // Error code of the phase
+    int line;                 // Source line (1-based)
+    int column;               // Source column (1-based, in bytes; 0 = unknown)
+    const char* lexeme;       // Interned text the error is about (never NULL)
+} Diagnostic;
+
+// Growable array of records. A zero-initialized list is empty and ready.
+typedef struct {
+    Diagnostic* items;
+    int count;
+    int capacity;
+    int dropped;              // Records lost to out-of-memory
+} DiagnosticList;
+
+typedef enum {
+    DIAGNOSTICS_TEXT,         // The classic messages, one per line
+    DIAGNOSTICS_JSON,         // One JSON object per line
+    DIAGNOSTICS_QUIET         // Nothing at all
+} DiagnosticFormat;
+
+void diagnostics_add(DiagnosticList* list, DiagnosticPhase phase, int code, int line, int column,
+                     const char* lexeme);
+void diagnostics_append(DiagnosticList* list, const Diagnostic* items, int count);
+void diagnostics_clear(DiagnosticList* list);  // Empty it, keeping the memory
+void diagnostics_free(DiagnosticList* list);
+
+// The text of one record as the text format prints it, without the
+// newline; returns its length, truncating to `size` like snprintf.
+int diagnostics_message(const Diagnostic* diagnostic, char* buffer, size_t size);
+
+// Print `count` records. JSON objects carry "file" when `file` is not NULL.
+void diagnostics_print(const Diagnostic* items, int count, DiagnosticFormat format,
+                       const char* file, FILE* out);
+
+// "text", "json" or "quiet"; 0 for anything else.
+int diagnostics_format_from_name(const char* name, DiagnosticFormat* format);
+
+#endif /* DIAGNOSTICS_H */
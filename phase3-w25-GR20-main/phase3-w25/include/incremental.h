@@ -0,0 +1,61 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include "parser.h"
+
+// Incremental front end for editor integration. A Document keeps the
+// source text as a sequence of top-level statements, each with its own
+// tree, syntax errors, semantic errors and the global names it uses.
+//
+// An edit re-lexes and reparses only the statements it touches (plus the
+// one before, whose parse may have looked one token ahead). Parsing stops
+// at the first statement boundary at or past the edit that is clean: a
+// statement without errors ending exactly where an old statement ended.
+// From there on the old tokens and trees are still right. Only the
+// reparsed statements are re-checked, plus later statements that mention
+// a global whose declared or initialized state the edit changed; those
+// may pass the change on. Statements after the edit only have their
+// offsets and line numbers moved, which is a pass over the statement
+// table, not the text.
+//
+// Diagnostics match a full parse (and, when there are no syntax errors, a
+// full check) of the current text. Variable slots in the trees are only
+// meaningful within each statement; run analyze_semantics_slots on
+// document_tree before executing it.
+
+typedef struct Document Document;
+
+// Work done by the last document_edit.
+typedef struct {
+    size_t relexed_bytes;     // Source bytes lexed again
+    int reparsed;             // Top-level statements parsed again
+    int rechecked;            // Top-level statements checked again
+} DocumentEditStats;
+
+Document *document_open(const char *text);  // NULL if out of memory
+void document_close(Document *doc);
+
+// Replace bytes [start, end) of the text with `length` bytes of `text`
+// (which must not contain NUL). Returns 0 for a bad range or on
+// out-of-memory, leaving the document unchanged in the former case.
+int document_edit(Document *doc, size_t start, size_t end, const char *text, size_t length);
+
+const char *document_text(const Document *doc);
+size_t document_length(const Document *doc);
+DocumentEditStats document_last_edit(const Document *doc);
+
+// Append what a full parse and check of the text would report: every
+// syntax error, or if there are none, every semantic error. Returns the
+// number of syntax errors. The lexemes live as long as the document.
+int document_diagnostics(Document *doc, DiagnosticList *out);
+
+// The same, printed in the text format.
+int document_print_diagnostics(Document *doc, FILE *out);
+
+// Program node over the statements that parsed, as from
+// parser_context_parse_partial. Valid until the next edit.
+ASTNode *document_tree(Document *doc);
+
+#endif /* INCREMENTAL_H */
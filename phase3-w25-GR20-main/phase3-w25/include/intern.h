@@ -0,0 +1,32 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <stddef.h>
+#include "arena.h"
+
+// String interning table. Every distinct string is stored once (in an arena)
+// and given a small integer ID, so equal strings share both the same ID and
+// the same pointer; comparing two interned strings is an integer compare.
+typedef struct {
+    const char* text;         // NUL-terminated interned copy
+    unsigned int length;      // Length in bytes, excluding the terminator
+    unsigned int hash;        // Cached hash of the bytes
+    long long value;          // Value of a number literal, set by whoever interns one (else 0)
+} InternEntry;
+
+typedef struct {
+    Arena storage;            // Backing store for the string bytes
+    InternEntry* entries;     // ID -> entry
+    unsigned int count;       // Number of interned strings
+    unsigned int capacity;    // Allocated length of entries[]
+    unsigned int* slots;      // Open-addressing index: 0 = empty, otherwise ID + 1
+    unsigned int slot_mask;   // Slot count - 1 (slot count is a power of two)
+} InternTable;
+
+// Interning operations.
+void intern_init(InternTable* table);
+unsigned int intern(InternTable* table, const char* text, size_t length);
+const char* intern_string(const InternTable* table, unsigned int id);
+void intern_free(InternTable* table);
+
+#endif /* INTERN_H */
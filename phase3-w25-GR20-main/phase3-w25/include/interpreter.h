@@ -0,0 +1,58 @@
+#ifndef INTERPRETER_H
+#define INTERPRETER_H
+
+#include <stdio.h>
+#include <setjmp.h>
+#include "parser.h"
+
+// Runtime value of every variable and expression.
+typedef long long Value;
+
+// Arithmetic shared by every execution engine. It wraps around like
+// two's-complement hardware instead of invoking undefined behaviour on overflow.
+static inline Value value_add(Value a, Value b) { return (Value)((unsigned long long)a + (unsigned long long)b); }
+static inline Value value_sub(Value a, Value b) { return (Value)((unsigned long long)a - (unsigned long long)b); }
+static inline Value value_mul(Value a, Value b) { return (Value)((unsigned long long)a * (unsigned long long)b); }
+// b must be nonzero; -1 is special-cased so LLONG_MIN / -1 wraps instead of trapping.
+static inline Value value_div(Value a, Value b) { return b == -1 ? value_sub(0, a) : a / b; }
+
+// factorial(n) = 1 * 2 * ... * n; 1 for n <= 1.
+static inline Value value_factorial(Value n) {
+    Value result = 1;
+    for (Value i = 2; i <= n; i++) {
+        result = value_mul(result, i);
+    }
+    return result;
+}
+
+// Runtime error codes.
+typedef enum {
+    RUNTIME_ERROR_NONE,
+    RUNTIME_ERROR_DIVISION_BY_ZERO,
+    RUNTIME_ERROR_UNRESOLVED_VARIABLE,  // Node was not annotated by semantic analysis
+    RUNTIME_ERROR_OUT_OF_MEMORY
+} RuntimeError;
+
+// Tree-walking evaluator state. Variables live in a flat frame indexed by
+// the slots semantic analysis stored on each declaration and identifier,
+// so no names are looked up while the program runs.
+typedef struct {
+    Value *slots;             // One value per variable slot
+    int slot_count;           // Length of slots[]
+    FILE *out;                // Where print statements and runtime errors go
+    RuntimeError error;       // First runtime error, if any
+    int error_line;           // Line of the statement that failed
+    jmp_buf on_error;         // Escape from a runtime error back to interpret
+} Interpreter;
+
+// Print "Runtime Error at line N: ..." for a runtime error code.
+void print_runtime_error(FILE *out, RuntimeError error, int line);
+
+// Run a program that analyze_semantics_slots accepted; slot_count is the
+// count it reported. Returns 1 on success, 0 after printing a runtime error.
+int interpret(ASTNode *program, int slot_count, FILE *out);
+
+// Same, using a caller-owned Interpreter so the error details can be inspected.
+int interpreter_run(Interpreter *interp, ASTNode *program, int slot_count, FILE *out);
+
+#endif /* INTERPRETER_H */
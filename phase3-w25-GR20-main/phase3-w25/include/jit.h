@@ -0,0 +1,39 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <stdio.h>
+#include "bytecode.h"
+
+// Baseline JIT for hot loops. The VM counts how often each backward jump
+// is taken; once a loop crosses the threshold its whole bytecode range is
+// translated to machine code (a direct template per instruction, with the
+// operand stack on the native stack) and later iterations run natively.
+// Loops containing anything the translator does not handle, and targets
+// without a backend (currently everything but x86-64 Linux/BSD/macOS),
+// simply keep running on the VM.
+
+#define JIT_DEFAULT_THRESHOLD 1000
+
+typedef struct JitCode JitCode;
+
+// 1 if this build can generate and execute machine code.
+int jit_available(void);
+
+// Translate the loop occupying instructions [start, end] of `chunk`, where
+// `end` is the backward jump to `start` and execution leaves the loop at
+// end + 1. Returns NULL if the loop cannot be compiled.
+JitCode *jit_compile_loop(const Chunk *chunk, int start, int end);
+
+// Run a compiled loop from its first instruction until it exits.
+// Returns 0 when the loop exits normally, or 1 + the index of the
+// instruction that raised a division by zero.
+int jit_run(const JitCode *code, Value *slots, FILE *out);
+
+void jit_free(JitCode *code);
+
+// vm_run with tiering: loops whose backward jump is taken `threshold`
+// times are compiled and continue natively (0 disables the JIT). Output
+// and runtime errors are identical to vm_run.
+int vm_run_jit(const Chunk *chunk, FILE *out, int threshold);
+
+#endif /* JIT_H */
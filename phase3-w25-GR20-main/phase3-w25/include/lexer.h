@@ -1,11 +1,87 @@
 #ifndef LEXER_H
 #define LEXER_H
 
+#include <stdio.h>
 #include "tokens.h"
+#include "intern.h"
+
+// Pre-lexed token stream, stored as parallel arrays (struct-of-arrays) so the
+// parser can index and look ahead cheaply. The lexeme of token i is the
+// source slice starting at offsets[i]; its text is intern_string(ids[i]).
+typedef struct {
+    unsigned char* types;     // TokenType of each token
+    unsigned char* errors;    // ErrorType of each token
+    int* lines;               // Source line of each token
+    int* columns;             // Source column of each token
+    int* offsets;             // Byte offset of each token in the source
+    unsigned int* ids;        // Interned lexeme ID of each token
+    int count;                // Number of tokens, including the final TOKEN_EOF
+    int capacity;             // Allocated length of each array
+    InternTable* strings;     // Table the IDs belong to
+} TokenBuffer;
+
+// Reentrant lexer state. Each Lexer (with its own InternTable) is independent,
+// so separate sources can be lexed on separate threads.
+typedef struct {
+    const char* input;        // NUL-terminated source text
+    int length;               // Bytes before the terminator (bounds the SIMD scans)
+    int pos;                  // Offset of the next unread byte
+    int line;                 // Current line number
+    int line_start;           // Offset where the current line begins (may be negative in a window)
+    InternTable* strings;     // Table that lexemes are interned into
+    int scalar_only;          // 1 = skip the SIMD fast paths (for benchmarking)
+} Lexer;
+
+// Refill callback for the streaming lexer: copy up to `capacity` bytes into
+// `buffer` and return how many were written (0 at end of input).
+typedef size_t (*LexerReadFn)(void* user, char* buffer, size_t capacity);
+
+// Streaming lexer for inputs that should not be loaded whole. Tokens are
+// scanned from a window that is refilled chunk by chunk; only the unread
+// tail is kept, so memory stays at about one chunk plus the longest token.
+// Tokens and comments may straddle chunk boundaries. The input must not
+// contain NUL bytes.
+typedef struct {
+    Lexer lexer;              // Scanner over the current window
+    LexerReadFn read;         // Source of more bytes
+    void* user;               // Passed to read
+    char* buffer;             // Window; always NUL-terminated at buffer[length]
+    size_t length;            // Bytes currently in the window
+    size_t capacity;          // Allocated size of buffer, excluding the terminator
+    size_t chunk_size;        // Bytes requested per refill
+    long long base_offset;    // Absolute input offset of buffer[0]
+    int eof;                  // read has reported end of input
+} StreamLexer;
+
+// Context-based lexer functions.
+int lexer_init_strings(InternTable* table);  // intern_init plus the reserved LexemeIds; 0 on out-of-memory
+void lexer_init(Lexer* lexer, const char* input, InternTable* table);
+Token lexer_next_token(Lexer* lexer);
+int lexer_tokenize(Lexer* lexer, TokenBuffer* tokens);
+
+// Streaming lexer functions.
+int stream_lexer_init(StreamLexer* stream, LexerReadFn read, void* user,
+                      size_t chunk_size, InternTable* table);  // 0 on out-of-memory
+int stream_lexer_init_file(StreamLexer* stream, FILE* file, size_t chunk_size, InternTable* table);
+Token stream_lexer_next(StreamLexer* stream);
+long long stream_lexer_offset(const StreamLexer* stream);  // Absolute offset of the next unread byte
+void stream_lexer_destroy(StreamLexer* stream);
 
 // Lexer functions that are visible to other files.
-Token get_next_token(const char* input, int* pos);
 void print_token(Token token);
 void print_error(ErrorType error, int line, const char* lexeme);
 
+// Legacy lexer functions, backed by one process-wide default lexer and string table.
+Token get_next_token(const char* input, int* pos);
+int tokenize(const char* input, TokenBuffer* tokens);  // Lex all of input in one pass; 0 on out-of-memory
+
+// Token stream functions.
+Token token_at(const TokenBuffer* tokens, int index);  // Indices past the end (or an empty buffer) yield EOF
+void free_token_buffer(TokenBuffer* tokens);
+
+// Table holding every lexeme returned by get_next_token and tokenize. Token
+// lexemes point into it, so it must outlive them.
+InternTable* lexer_strings(void);
+void lexer_free_strings(void);
+
 #endif /* LEXER_H */
@@ -0,0 +1,28 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "parser.h"
+#include "intern.h"
+
+// What fold_constants changed.
+typedef struct {
+    int folded;               // Operators and calls replaced by their constant value
+    int simplified;           // Algebraic identities applied (x+0, x*1, x*0, ...)
+    int pruned;               // if/while/repeat statements resolved at compile time
+    int dead_stores;          // Assignments whose value is never read
+} FoldStats;
+
+// Fold constant subexpressions, apply algebraic identities and remove
+// control flow with constant conditions, in place. Run it on a tree that
+// analyze_semantics_slots accepted: folding keeps the slot annotations,
+// so the result can go straight to the interpreter or bytecode compiler.
+// New literals are interned into `strings` (the table the tree was lexed
+// into). Removed statements are dropped from their program or block.
+// Arithmetic follows the interpreter (wraparound), and divisions
+// by a constant zero are left in place so they still fail at run time.
+// Finally, liveness on the program's control flow graph (see cfg.h)
+// removes stores whose value no path reads, unless computing the value
+// could fail; the program node's frame_size must cover every slot.
+void fold_constants(ASTNode* program, InternTable* strings, FoldStats* stats);
+
+#endif /* OPTIMIZER_H */
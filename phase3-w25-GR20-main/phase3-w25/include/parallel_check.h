@@ -0,0 +1,30 @@
+#ifndef PARALLEL_CHECK_H
+#define PARALLEL_CHECK_H
+
+#include "parser.h"
+
+// Parallel semantic analysis for programs made of many top-level blocks.
+// A block can only read and initialize globals (its declarations die with
+// it), and which globals exist before each statement is fixed by the
+// top-level declarations alone. So one pass over the top-level statements
+// builds an immutable snapshot of the globals, and every top-level block
+// is checked on the thread pool against it, in a private table that
+// records its diagnostics. A guess at which globals are initialized at
+// the block comes from the non-block statements before it.
+//
+// A serial merge then walks the statements in source order with the real
+// table: other statements are checked there, and a block's buffered
+// result is kept if every global it mentions has the initialized state it
+// was checked with (applying what it initialized), or else the block is
+// checked again in place. A last parallel pass gives the kept blocks
+// their real variable slots.
+
+#define PARALLEL_CHECK_MIN_BLOCKS 64        // Fewer top-level blocks: check serially
+#define PARALLEL_CHECK_JOBS_PER_THREAD 8    // Jobs (and buffers) per worker thread
+
+// Same result, diagnostics and slot numbering as analyze_semantics_record.
+// Falls back to it for small programs, one thread or out-of-memory.
+int analyze_semantics_parallel(ASTNode* ast, DiagnosticList* diagnostics, int* slot_count,
+                               int thread_count);
+
+#endif /* PARALLEL_CHECK_H */
@@ -1,23 +1,59 @@
 #ifndef PARSER_H
 #define PARSER_H
 
+#include <stdio.h>
+#include <setjmp.h>
 #include "tokens.h"
+#include "lexer.h"
+#include "arena.h"
+#include "spsc_ring.h"
+#include "diagnostics.h"
 
-// AST Node types for our language constructs.
+// Fields of a node that can hold its children.
+enum {
+    AST_CHILD_LIST = 1,         // children/child_count
+    AST_CHILD_LEFT = 2,
+    AST_CHILD_RIGHT = 4,
+    AST_CHILD_ELSE = 8
+};
+
+// AST Node types for our language constructs, one X(kind, label,
+// shows_lexeme, children) entry each in enum order. print_ast shows a node
+// as its label, followed by ": lexeme" if shows_lexeme is set; children is
+// the AST_CHILD_* fields the kind uses, which is all that generic walks
+// (see ast_visit.h) look at.
+#define AST_NODE_KINDS(X) \
+    X(AST_PROGRAM,    "Program",      0, AST_CHILD_LIST)      /* Program node (sequence of statements) */ \
+    X(AST_VARDECL,    "VarDecl",      1, 0)                   /* Variable declaration (e.g., int x) */ \
+    X(AST_ASSIGN,     "Assign",       0, AST_CHILD_LEFT | AST_CHILD_RIGHT) /* Assignment (e.g., x = 5) */ \
+    X(AST_PRINT,      "Print",        0, AST_CHILD_LEFT)      /* Print statement */ \
+    X(AST_NUMBER,     "Number",       1, 0)                   /* Number literal */ \
+    X(AST_IDENTIFIER, "Identifier",   1, 0)                   /* Variable or function name */ \
+    X(AST_BINOP,      "BinaryOp",     1, AST_CHILD_LEFT | AST_CHILD_RIGHT) /* Binary operator node (e.g., +, -, *, /, <, >, etc.) */ \
+    X(AST_IF,         "If",           0, AST_CHILD_LEFT | AST_CHILD_RIGHT | AST_CHILD_ELSE) /* If statement */ \
+    X(AST_WHILE,      "While",        0, AST_CHILD_LEFT | AST_CHILD_RIGHT) /* While loop */ \
+    X(AST_REPEAT,     "Repeat-Until", 0, AST_CHILD_LEFT | AST_CHILD_RIGHT) /* Repeat-until loop */ \
+    X(AST_BLOCK,      "Block",        0, AST_CHILD_LIST)      /* Block of statements: { ... } */ \
+    X(AST_FUNCALL,    "FuncCall",     1, AST_CHILD_LEFT)      /* Function call (e.g., factorial(x)) */
+
+#define AST_KIND_ENUM(kind, label, shows_lexeme, children) kind,
 typedef enum {
-    AST_PROGRAM,        // Program node (sequence of statements)
-    AST_VARDECL,        // Variable declaration (e.g., int x)
-    AST_ASSIGN,         // Assignment (e.g., x = 5)
-    AST_PRINT,          // Print statement
-    AST_NUMBER,         // Number literal
-    AST_IDENTIFIER,     // Variable or function name
-    AST_BINOP,          // Binary operator node (e.g., +, -, *, /, <, >, etc.)
-    AST_IF,             // If statement
-    AST_WHILE,          // While loop
-    AST_REPEAT,         // Repeat-until loop
-    AST_BLOCK,          // Block of statements: { ... }
-    AST_FUNCALL         // Function call (e.g., factorial(x))
+    AST_NODE_KINDS(AST_KIND_ENUM)
 } ASTNodeType;
+#undef AST_KIND_ENUM
+
+#define AST_KIND_ONE(kind, label, shows_lexeme, children) +1
+enum { AST_KIND_COUNT = 0 AST_NODE_KINDS(AST_KIND_ONE) };  // Number of node kinds
+#undef AST_KIND_ONE
+
+// What AST_NODE_KINDS says about one kind; index ast_kinds by ASTNodeType.
+typedef struct {
+    const char *label;
+    int shows_lexeme;
+    unsigned int children;      // AST_CHILD_* flags
+} ASTKindInfo;
+
+extern const ASTKindInfo ast_kinds[AST_KIND_COUNT];
 
 // Extended parse error codes.
 typedef enum {
@@ -32,23 +68,84 @@ typedef enum {
     PARSE_ERROR_MISSING_CONDITION,
     PARSE_ERROR_MISSING_BLOCK,
     PARSE_ERROR_INVALID_OPERATOR,
-    PARSE_ERROR_FUNCTION_CALL
+    PARSE_ERROR_FUNCTION_CALL,
+    PARSE_ERROR_NESTING_TOO_DEEP,
+    PARSE_ERROR_EXPECTED_PRIMARY,     // No operand where an expression must start
+    PARSE_ERROR_UNEXPECTED_STATEMENT  // No statement starts with this token
 } ParseError;
 
+// Deepest nesting of statements (blocks, loop and if bodies, else arms)
+// and of parentheses/calls the parser accepts; deeper input is a syntax error.
+#define PARSER_MAX_NESTING 256
+// Tallest expression tree the parser builds (e.g. a sum of that many terms).
+// With PARSER_MAX_NESTING this bounds the height of every AST, so passes
+// may recurse into children; statement lists are always walked iteratively.
+#define PARSER_MAX_EXPRESSION_DEPTH 4096
+
 // AST Node structure.
 // Note: We add an "else_branch" pointer for if-statements.
+// AST_PROGRAM and AST_BLOCK keep their statements in one contiguous array
+// (children/child_count, allocated in the parser arena) and leave left and
+// right NULL; every other node uses only left, right and else_branch.
 typedef struct ASTNode {
     ASTNodeType type;           // Node type
     Token token;                // Associated token (useful for error messages)
-    struct ASTNode* left;       // Left child (e.g., condition, first statement)
-    struct ASTNode* right;      // Right child (e.g., then-branch or next statement)
+    struct ASTNode* left;       // Left child (e.g., condition, loop body)
+    struct ASTNode* right;      // Right child (e.g., then-branch or assigned value)
     struct ASTNode* else_branch; // Optional else branch for if-statements
+    struct ASTNode** children;  // Statements of a program or block, in order
+    int child_count;            // Number of entries in children
+    int slot;                   // Variable slot resolved by semantic analysis (-1 = none)
+    int depth;                  // Scope depth of that variable's declaration (0 = global; blocks: their own)
+    int frame_size;             // Program or block: slots declared in it, nested blocks included
 } ASTNode;
 
-// Parser interface functions.
-void parser_init(const char *input);
-ASTNode* parse(void);
+// Reentrant parser state: tokens, lexemes and nodes of one parse.
+// Contexts share nothing, so one parse per thread is safe.
+// A zero-initialized Parser is ready for parser_context_init.
+// A syntax error abandons only the statement it occurs in: the parser
+// skips ahead to the next ';' or '}' and carries on, so one parse reports
+// every error and still produces a tree of the statements that parsed.
+// Errors are recorded in `diagnostics`, never printed; print them with
+// diagnostics_print.
+typedef struct {
+    InternTable strings;         // Lexemes of this context
+    int strings_ready;           // strings has been initialized
+    TokenBuffer owned_tokens;    // Stream lexed by parser_context_init
+    const TokenBuffer *tokens;   // Stream being parsed
+    SpscRing *ring;              // Tokens pushed by a lexer thread, used instead of tokens
+    int token_index;             // Index of the current token
+    Token current;               // Current token
+    Arena arena;                 // Backing store for every AST node
+    jmp_buf on_error;            // Escape from a syntax error to the statement being recovered
+    int depth;                   // Statement nesting at the current token
+    ASTNode **pending;           // Statements of the lists still being parsed
+    int pending_count;
+    int pending_capacity;
+    DiagnosticList diagnostics;  // Syntax errors of the last parse (DIAGNOSTIC_SYNTAX)
+} Parser;
+
+// Context-based parser interface.
+int parser_context_init(Parser *parser, const char *input);  // 0 on out-of-memory (the stream is then empty)
+void parser_context_init_tokens(Parser *parser, const TokenBuffer *stream);
+void parser_context_init_ring(Parser *parser, SpscRing *ring);  // Ring of Token ending with TOKEN_EOF
+ASTNode* parser_context_parse(Parser *parser);     // NULL on a syntax error
+ASTNode* parser_context_parse_partial(Parser *parser); // Tree of the statements that parsed, even after errors
+int parser_context_parse_next(Parser *parser, ASTNode **statement); // One top-level statement; 0 at the end
+void parser_context_reset(Parser *parser);    // Free all nodes of the context at once
+void parser_context_destroy(Parser *parser);
+
+// Parser interface functions (wrappers over a default context).
+int parser_init(const char *input);                  // Lexes the whole input up front; 0 on out-of-memory
+void parser_init_tokens(const TokenBuffer *stream);  // Parse a pre-lexed token stream
+ASTNode* parse(void);                                // Prints the syntax errors to stdout
 void print_ast(ASTNode *node, int level);
-void free_ast(ASTNode *node);
+void print_ast_label(FILE *out, ASTNodeType type, const char *lexeme); // One node, as print_ast shows it
+void free_ast(ASTNode *node);     // Releases a default-context tree (and any other tree in that arena)
+
+// Node arena management. Every node returned by parse() lives in a parser-owned arena.
+void parser_arena_reset(void);    // Free all nodes at once; keeps a chunk for reuse
+void parser_arena_destroy(void);  // Free all nodes and return the arena memory
+void parser_cleanup(void);        // Free everything held by the default context
 
 #endif /* PARSER_H */
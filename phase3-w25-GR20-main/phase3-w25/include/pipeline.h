@@ -0,0 +1,35 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "parser.h"
+
+// Pipelined front end for large inputs. The lexer runs on one thread and
+// pushes tokens into a lock-free SPSC ring; the parser runs on a second
+// thread, reading that ring and pushing each completed top-level
+// statement into another ring; the calling thread runs check_statement on
+// the statements as they arrive. The stages overlap, so on a multi-core
+// machine the wall time approaches that of the slowest stage rather than
+// the sum of all three.
+
+#define PIPELINE_TOKEN_CAPACITY 4096      // Tokens the lexer may run ahead
+#define PIPELINE_STATEMENT_CAPACITY 1024  // Statements the parser may run ahead
+
+typedef struct {
+    ASTNode* program;         // Statements that parsed, as from parser_context_parse_partial
+    int tokens;               // Tokens lexed, including the final EOF
+    int syntax_errors;        // Syntax errors found (parser->diagnostics.count)
+    int valid;                // 1 if there were no syntax or semantic errors
+    int slot_count;           // Variable slots the checked program uses
+} PipelineResult;
+
+// Lex, parse and check `input`, recording exactly what
+// parser_context_parse followed by analyze_semantics_record would: syntax
+// errors in parser->diagnostics, then, only if there were none, the
+// semantic errors appended to `semantic`. `parser` must be
+// zero-initialized; afterwards its arena and string table hold the tree,
+// as after parser_context_init. Returns 0, leaving no tree or diagnostics,
+// if the buffers or the lexer thread cannot be created or the lexer runs
+// out of memory.
+int pipeline_run(Parser* parser, const char* input, DiagnosticList* semantic, PipelineResult* result);
+
+#endif /* PIPELINE_H */
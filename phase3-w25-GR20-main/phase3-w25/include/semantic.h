@@ -1,31 +1,62 @@
 #ifndef SEMANTIC_H
 #define SEMANTIC_H
 
+#include <stdio.h>
 #include "parser.h"   // For the ASTNode structure
 #include "tokens.h"   // For token definitions (e.g., TOKEN_INT)
+#include "diagnostics.h"
 
 /* ============================
    Symbol Table Structures
    ============================ */
 typedef struct Symbol {
-    char name[100];           // Identifier name
+    const char* name;         // Interned identifier name (see lexer_strings)
     int type;                 // Data type (e.g., TOKEN_INT)
     int scope_level;          // Nesting scope level
     int line_declared;        // Line number where declared
-    int is_initialized;       // Flag: 0 = not initialized, 1 = initialized
-    struct Symbol* next;      // Pointer for linked list implementation
+    int is_initialized;       // Flag: 1 = assigned on every path to the point being checked
+    int slot;                 // Runtime variable slot (unique per declaration)
+    struct Symbol* next;      // Same-named symbol it shadows in an enclosing scope
 } Symbol;
 
+// Hash slot: one per distinct name ever declared. Keys are never removed;
+// the slot's symbol becomes NULL once no declaration of the name is live.
 typedef struct {
-    Symbol* head;             // Head of the symbol list
+    const char* name;         // Interned name (NULL = empty slot)
+    Symbol* symbol;           // Innermost live declaration of the name
+} SymbolSlot;
+
+// Open-addressing hash table keyed by interned name, plus an undo stack of
+// live symbols in declaration order. Lookups are O(1) and exiting a scope
+// only touches the symbols that scope declared.
+// A lookup that finds no live symbol asks `resolve`, if set: a table can
+// stand in for part of a larger scope without copying its symbols in.
+typedef struct {
+    SymbolSlot* slots;        // Hash slots (power-of-two count)
+    unsigned int slot_mask;   // Slot count - 1
+    unsigned int slot_used;   // Slots holding a key
+    Symbol** declared;        // Undo stack of live symbols, innermost scope on top
+    int count;                // Number of live symbols
+    int capacity;             // Allocated length of declared[]
     int current_scope;        // Current scope level
+    int slot_count;           // Slots handed out so far (size of a runtime frame)
+    FILE* out;                // Stream for dumps (stdout by default)
+    DiagnosticList diagnostics;  // Errors found so far (DIAGNOSTIC_SEMANTIC)
+    Symbol** assigned;        // Symbols initialized inside the open if/while branches, oldest first
+    int assigned_count;       // Entries in assigned[]
+    int assigned_capacity;    // Allocated length of assigned[]
+    int branch_depth;         // if/while bodies being checked (0 = no marks to undo)
+    Symbol* (*resolve)(void* context, const char* name);  // Fallback lookup (NULL = none)
+    void* resolve_context;    // Passed to resolve
 } SymbolTable;
 
 /* ============================
    Symbol Table Operations
    ============================ */
+// Names passed to these functions must be interned lexemes (token.lexeme);
+// symbols are matched by pointer identity rather than strcmp.
 SymbolTable* init_symbol_table();
-void add_symbol(SymbolTable* table, const char* name, int type, int line);
+Symbol* add_symbol(SymbolTable* table, const char* name, int type, int line);
 Symbol* lookup_symbol(SymbolTable* table, const char* name);
 Symbol* lookup_symbol_current_scope(SymbolTable* table, const char* name);
 void enter_scope(SymbolTable* table);
@@ -47,12 +78,18 @@ typedef enum {
     SEM_ERROR_SEMANTIC_ERROR
 } SemanticErrorType;
 
+// The checker records its errors in table->diagnostics; these format a
+// single error as the text format does.
 void semantic_error(SemanticErrorType error, const char* name, int line);
+void semantic_error_to(FILE* out, SemanticErrorType error, const char* name, int line);
 
 /* ============================
    Semantic Analysis Functions
    ============================ */
 int analyze_semantics(ASTNode* ast);
+int analyze_semantics_to(ASTNode* ast, FILE* out, int dump_table);
+int analyze_semantics_slots(ASTNode* ast, FILE* out, int dump_table, int* slot_count);
+int analyze_semantics_record(ASTNode* ast, DiagnosticList* diagnostics, int* slot_count);
 int check_program(ASTNode* node, SymbolTable* table);
 int check_statement(ASTNode* node, SymbolTable* table);
 int check_declaration(ASTNode* node, SymbolTable* table);
@@ -0,0 +1,21 @@
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <stddef.h>
+
+// A loaded source file. The text is always NUL-terminated and read-only;
+// it is either a private file mapping or a heap buffer.
+typedef struct {
+    const char* data;         // File contents followed by '\0'
+    size_t size;              // Length in bytes, excluding the terminator
+    int mapped;               // 1 if data is an mmap'd view of the file
+    void* buffer;             // Heap copy when not mapped (NULL otherwise)
+} SourceFile;
+
+// Source file loading.
+int source_open(SourceFile* source, const char* filename);  // 1 on success
+int source_open_binary(SourceFile* source, const char* filename);  // No terminator, no error message
+void source_close(SourceFile* source);
+char* read_file(const char* filename);  // Heap copy of the contents, or NULL on failure
+
+#endif /* SOURCE_H */
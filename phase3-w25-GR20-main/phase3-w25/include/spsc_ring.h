@@ -0,0 +1,37 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+
+// Bounded lock-free queue between one producer thread and one consumer
+// thread, holding fixed-size elements. The producer only advances `tail`
+// and the consumer only advances `head`, each with a release store that
+// the other side reads with acquire, so no locks are taken. Elements are
+// addressed by absolute index (0, 1, 2, ... in push order): the consumer
+// may read any element it has not released yet, which gives it lookahead.
+// A side that must wait spins briefly, then yields the CPU.
+typedef struct {
+    unsigned char* slots;             // capacity * element_size bytes
+    size_t element_size;
+    size_t mask;                      // Capacity - 1 (capacity is a power of two)
+    _Alignas(64) atomic_size_t head;  // Elements below this index are released
+    _Alignas(64) atomic_size_t tail;  // Elements below this index are published
+    atomic_int closed;                // The producer is done; tail is final
+} SpscRing;
+
+// Ring operations.
+int spsc_ring_init(SpscRing* ring, size_t element_size, size_t capacity);  // 0 on out-of-memory
+void spsc_ring_destroy(SpscRing* ring);
+
+// Producer side.
+void spsc_ring_push(SpscRing* ring, const void* element);  // Waits while the ring is full
+void spsc_ring_close(SpscRing* ring);                      // No more elements will follow
+
+// Consumer side. spsc_ring_get waits until element `index` is pushed and
+// returns it, or NULL if the ring was closed first; the element stays
+// valid until it is released.
+const void* spsc_ring_get(SpscRing* ring, size_t index);
+void spsc_ring_release(SpscRing* ring, size_t index);      // Elements below `index` may be reused
+
+#endif /* SPSC_RING_H */
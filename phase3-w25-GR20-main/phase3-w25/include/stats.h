@@ -0,0 +1,66 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+
+// Front end instrumentation for --stats: phase timers on the monotonic
+// clock and a few counters (tokens lexed, AST nodes, arena bytes, symbol
+// lookups, peak scope depth). The hot paths bump a thread-local record,
+// so no locking or atomics are needed; whoever runs work on other threads
+// moves their records over with stats_take there and stats_put here.
+//
+// Configure with -DFRONTEND_STATS=OFF and every STATS_* macro expands to
+// nothing: the counters and timers are compiled out of the front end.
+
+#ifndef FRONTEND_STATS
+#define FRONTEND_STATS 0
+#endif
+
+typedef enum {
+    STATS_LEX,                // lexer_tokenize (or the pipeline's lexer thread)
+    STATS_PARSE,              // parser_context_parse_partial (or the parser thread)
+    STATS_CHECK,              // Semantic analysis
+    STATS_FOLD,               // fold_constants
+    STATS_BYTECODE,           // bytecode_compile
+    STATS_RUN,                // Interpreter or VM
+    STATS_PHASE_COUNT
+} StatsPhase;
+
+typedef struct {
+    double seconds[STATS_PHASE_COUNT];  // Time spent in each phase, summed over threads
+    long long tokens;         // Tokens lexed, including each EOF
+    long long nodes;          // AST nodes the parser created
+    long long bytes;          // Bytes handed out by arenas
+    long long lookups;        // Symbol table lookups
+    int peak_scope_depth;     // Deepest scope the checker entered (0 = top level)
+} FrontendStats;
+
+#if FRONTEND_STATS
+extern _Thread_local FrontendStats stats_thread;  // This thread's record
+
+#define STATS_COUNT(field, n) (stats_thread.field += (n))
+#define STATS_PEAK(field, value) \
+    ((value) > stats_thread.field ? (void)(stats_thread.field = (value)) : (void)0)
+#define STATS_START(timer) double timer = stats_now()
+#define STATS_STOP(phase, timer) (stats_thread.seconds[phase] += stats_now() - (timer))
+#else
+#define STATS_COUNT(field, n) ((void)0)
+#define STATS_PEAK(field, value) ((void)0)
+#define STATS_START(timer) ((void)0)
+#define STATS_STOP(phase, timer) ((void)0)
+#endif
+
+double stats_now(void);   // Monotonic clock, in seconds
+
+// Add this thread's record to `into` (if not NULL) and zero it.
+void stats_take(FrontendStats* into);
+// Add `from` to this thread's record.
+void stats_put(const FrontendStats* from);
+// Add `from` to `into`: times and counts are summed, peaks take the maximum.
+void stats_add(FrontendStats* into, const FrontendStats* from);
+
+// Print a report: a table, or one JSON object on a line of its own.
+// With FRONTEND_STATS off both say that nothing was counted.
+void stats_print(const FrontendStats* stats, int json, FILE* out);
+
+#endif /* STATS_H */
@@ -0,0 +1,12 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+// Fork-join work-stealing pool. Jobs 0..job_count-1 are split evenly across
+// the workers' queues up front; a worker that runs out steals half of the
+// remaining jobs of another worker, so uneven job costs still balance.
+typedef void (*ThreadPoolJob)(void* context, int job);
+
+int thread_pool_run(int job_count, int thread_count, ThreadPoolJob job, void* context);
+int thread_pool_default_threads(void);  // Number of online CPUs (at least 1)
+
+#endif /* THREAD_POOL_H */
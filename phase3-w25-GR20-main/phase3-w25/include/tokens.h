@@ -30,11 +30,40 @@ typedef enum {
     ERROR_UNEXPECTED_TOKEN
 } ErrorType;
 
+// Lexemes interned by the lexer before anything else, in this order, so
+// their IDs are compile-time constants the parser can compare against.
+typedef enum {
+    LEXEME_EMPTY,       // ""
+    LEXEME_EOF,         // "EOF"
+    LEXEME_ELSE,        // "else"
+    LEXEME_FACTORIAL,   // "factorial"
+    LEXEME_IF,          // "if"
+    LEXEME_WHILE,       // "while"
+    LEXEME_REPEAT,      // "repeat"
+    LEXEME_UNTIL,       // "until"
+    LEXEME_INT,         // "int"
+    LEXEME_PRINT,       // "print"
+    LEXEME_PLUS,        // "+"
+    LEXEME_MINUS,       // "-"
+    LEXEME_STAR,        // "*"
+    LEXEME_SLASH,       // "/"
+    LEXEME_LT,          // "<"
+    LEXEME_GT,          // ">"
+    LEXEME_LE,          // "<="
+    LEXEME_GE,          // ">="
+    LEXEME_EQ,          // "=="
+    LEXEME_NE,          // "!="
+    LEXEME_RESERVED_COUNT
+} LexemeId;
+
 typedef struct {
     TokenType type;
-    char lexeme[100];   // Actual text of the token
+    const char* lexeme; // Interned text of the token (equal lexemes share one copy)
+    unsigned int id;    // Interned lexeme ID: equal IDs <=> equal text
     int line;           // Line number in the source file
+    int column;         // Column of the lexeme's first byte (1-based)
     ErrorType error;    // Error type, if any
+    long long value;    // Value of a TOKEN_NUMBER, converted once by the lexer (0 otherwise)
 } Token;
 
 #endif /* TOKENS_H */
@@ -0,0 +1,298 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "../../include/lexer.h"
+#include "../../include/parser.h"
+#include "../../include/ast_visit.h"
+#include "../../include/semantic.h"
+
+// -----------------------------------------------------------------
+// Front end benchmark suite: generates synthetic programs of several
+// shapes at sizes from --min to --max (growing 4x per step) and measures
+// lexer tokens/s, parser nodes/s, checker nodes/s and peak RSS for each.
+// Every (shape, size) runs in a child process, so its peak RSS is its
+// own. Results are JSON lines on stdout, one per measurement.
+// usage: bench [--min SIZE] [--max SIZE] [--rounds N] [--shape NAME]
+// -----------------------------------------------------------------
+
+#define BENCH_MAX_SIZE (1LL << 30)  // Token offsets are ints; stay well below 2 GB
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// -----------------------------------------------------------------
+// Generators. Each writes a valid program (no syntax or semantic errors)
+// of at least `size` bytes, one self-contained unit at a time.
+// -----------------------------------------------------------------
+
+typedef struct {
+    char* data;
+    size_t length;
+    size_t capacity;
+} Text;
+
+static void append(Text* text, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+static void append(Text* text, const char* format, ...) {
+    va_list args;
+    for (;;) {
+        va_start(args, format);
+        size_t room = text->capacity - text->length;
+        int written = vsnprintf(text->data + text->length, room, format, args);
+        va_end(args);
+        if (written >= 0 && (size_t)written < room) {
+            text->length += (size_t)written;
+            return;
+        }
+        size_t capacity = text->capacity * 2 + (size_t)written + 1;
+        char* data = realloc(text->data, capacity);
+        if (!data) {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+        text->data = data;
+        text->capacity = capacity;
+    }
+}
+
+// Long statement list: one new global per unit, used right away.
+static void unit_statements(Text* text, long i, int width) {
+    (void)width;
+    append(text, "int s%ld;\ns%ld = v0 * 3 + %ld;\nprint s%ld;\n", i, i, i % 97, i);
+}
+
+// Deep nesting: a tower of `width` blocks, ifs, whiles and repeats.
+static void unit_nesting(Text* text, long i, int width) {
+    static const char* const opens[] = {"{\n", "if (v0 > 0) {\n", "while (v0 < 0) {\n", "repeat {\n"};
+    static const char* const closes[] = {"}\n", "}\n", "}\n", "} until (v0 > 0);\n"};
+    for (int d = 0; d < width; d++) {
+        append(text, "%s", opens[(d + i) % 4]);
+    }
+    append(text, "v0 = v0 + %ld;\n", i % 89);
+    for (int d = width - 1; d >= 0; d--) {
+        append(text, "%s", closes[(d + i) % 4]);
+    }
+}
+
+// Wide expressions: one assignment of `width` terms with mixed precedence.
+static void unit_expressions(Text* text, long i, int width) {
+    static const char* const terms[] = {"v0 * 3", "(v1 + %ld)", "v2 / 7", "factorial(4)", "%ld", "v1 - v2"};
+    append(text, "v%ld = v0", i % 3);
+    for (int t = 0; t < width; t++) {
+        append(text, t % 2 ? " - " : " + ");
+        append(text, terms[t % 6], (long)t);
+    }
+    append(text, ";\n");
+}
+
+// Many declarations per scope: a block declaring `width` locals.
+static void unit_declarations(Text* text, long i, int width) {
+    append(text, "{\n");
+    for (int d = 0; d < width; d++) {
+        append(text, "    int local_%d;\n    local_%d = v0 + %ld;\n", d, d, i % 71);
+    }
+    append(text, "}\n");
+}
+
+// Comment-heavy: each statement under a long block comment.
+static void unit_comments(Text* text, long i, int width) {
+    (void)width;
+    append(text, "/* Unit %ld: this comment stands in for the documentation that real\n"
+                 " * code carries; the lexer skips it in bulk, newlines included, and\n"
+                 " * only the single statement below produces any tokens at all. */\n"
+                 "v0 = v0 + %ld;\n", i, i % 83);
+}
+
+typedef struct {
+    const char* name;
+    void (*unit)(Text* text, long i, int width);
+    int max_width;            // Depth, terms or declarations per unit at large sizes
+} Shape;
+
+// Nesting stays under PARSER_MAX_NESTING and expressions well under
+// PARSER_MAX_EXPRESSION_DEPTH, so every size parses.
+static const Shape shapes[] = {
+    {"statements", unit_statements, 1},
+    {"nesting", unit_nesting, 200},
+    {"expressions", unit_expressions, 1000},
+    {"declarations", unit_declarations, 1000},
+    {"comments", unit_comments, 1},
+};
+
+static char* generate(const Shape* shape, long long size, size_t* length) {
+    Text text = {malloc(4096), 0, 4096};
+    if (!text.data) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    // Units shrink with the program so even 1 KB holds several of them.
+    long long width = size / 256;
+    if (width < 4) width = 4;
+    if (width > shape->max_width) width = shape->max_width;
+    append(&text, "int v0; int v1; int v2;\nv0 = 1; v1 = 2; v2 = 3;\n");
+    for (long i = 0; (long long)text.length < size; i++) {
+        shape->unit(&text, i, (int)width);
+    }
+    *length = text.length;
+    return text.data;
+}
+
+// -----------------------------------------------------------------
+// Measurement
+// -----------------------------------------------------------------
+
+static AstWalkAction count_node(const AstVisit* visit, void* context) {
+    (void)visit;
+    ++*(long*)context;
+    return AST_WALK_CONTINUE;
+}
+
+static long count_nodes(ASTNode* node) {
+    long count = 0;
+    AstVisitor counter = {count_node, NULL, &count};
+    ast_walk(node, &counter, 1);
+    return count;
+}
+
+// Best-of-`rounds` times for each phase of one program, printed as a JSON line.
+static int measure(const Shape* shape, long long size, int rounds) {
+    size_t bytes;
+    char* source = generate(shape, size, &bytes);
+    InternTable strings;
+    int valid = lexer_init_strings(&strings);  // Reported as invalid if it ran out of memory
+    TokenBuffer tokens = {0};
+    Parser parser = {0};
+    DiagnosticList diagnostics = {0};
+    double lex = 0, parse = 0, check = 0;
+    ASTNode* ast = NULL;
+    for (int r = 0; r < rounds && valid; r++) {
+        Lexer lexer;
+        lexer_init(&lexer, source, &strings);
+        double start = now_seconds();
+        valid = lexer_tokenize(&lexer, &tokens);
+        double lexed = now_seconds();
+        parser_context_reset(&parser);
+        parser_context_init_tokens(&parser, &tokens);
+        ast = valid ? parser_context_parse(&parser) : NULL;
+        double parsed = now_seconds();
+        diagnostics_clear(&diagnostics);
+        valid = ast && analyze_semantics_record(ast, &diagnostics, NULL) && diagnostics.count == 0;
+        double checked = now_seconds();
+        if (r == 0 || lexed - start < lex) lex = lexed - start;
+        if (r == 0 || parsed - lexed < parse) parse = parsed - lexed;
+        if (r == 0 || checked - parsed < check) check = checked - parsed;
+    }
+    long nodes = count_nodes(ast);
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    if (lex <= 0) lex = 1e-9;
+    if (parse <= 0) parse = 1e-9;
+    if (check <= 0) check = 1e-9;
+    printf("{\"shape\":\"%s\",\"bytes\":%zu,\"tokens\":%d,\"nodes\":%ld,\"rounds\":%d,\"valid\":%s,"
+           "\"lex_s\":%.6f,\"parse_s\":%.6f,\"check_s\":%.6f,"
+           "\"tokens_per_s\":%.0f,\"parse_nodes_per_s\":%.0f,\"check_nodes_per_s\":%.0f,"
+           "\"peak_rss_kb\":%ld}\n",
+           shape->name, bytes, tokens.count, nodes, rounds, valid ? "true" : "false",
+           lex, parse, check, tokens.count / lex, nodes / parse, nodes / check, usage.ru_maxrss);
+    fflush(stdout);
+    diagnostics_free(&diagnostics);
+    parser_context_destroy(&parser);
+    free_token_buffer(&tokens);
+    intern_free(&strings);
+    free(source);
+    return valid;
+}
+
+// Run `measure` in a child; report its failure (out of memory, killed) as a JSON line too.
+static int measure_isolated(const Shape* shape, long long size, int rounds) {
+    fflush(stdout);
+    pid_t child = fork();
+    if (child < 0) {
+        perror("fork");
+        return 0;
+    }
+    if (child == 0) {
+        _exit(measure(shape, size, rounds) ? 0 : 1);
+    }
+    int status;
+    if (waitpid(child, &status, 0) < 0 || !WIFEXITED(status)) {
+        printf("{\"shape\":\"%s\",\"size\":%lld,\"error\":\"measurement process failed\"}\n",
+               shape->name, size);
+        return 0;
+    }
+    return WEXITSTATUS(status) == 0;
+}
+
+// "64", "16K", "4M" or "1G".
+static long long parse_size(const char* text) {
+    char* end;
+    long long size = strtoll(text, &end, 10);
+    switch (*end) {
+        case 'k': case 'K': size <<= 10; end++; break;
+        case 'm': case 'M': size <<= 20; end++; break;
+        case 'g': case 'G': size <<= 30; end++; break;
+        default: break;
+    }
+    return *end || size <= 0 || size > BENCH_MAX_SIZE ? -1 : size;
+}
+
+static void usage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s [--min SIZE] [--max SIZE] [--rounds N] [--shape NAME]\n"
+            "  --min SIZE     smallest program (default 1K)\n"
+            "  --max SIZE     largest program, up to 1G (default 16M)\n"
+            "  --rounds N     best of N passes per phase (default 3)\n"
+            "  --shape NAME   statements, nesting, expressions, declarations or comments\n"
+            "                 (default: all)\n",
+            program);
+}
+
+int main(int argc, char** argv) {
+    long long min_size = 1 << 10;
+    long long max_size = 16 << 20;
+    int rounds = 3;
+    const char* only = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--min") == 0 && i + 1 < argc) {
+            min_size = parse_size(argv[++i]);
+        } else if (strcmp(argv[i], "--max") == 0 && i + 1 < argc) {
+            max_size = parse_size(argv[++i]);
+        } else if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+            rounds = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--shape") == 0 && i + 1 < argc) {
+            only = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (min_size < 0 || max_size < min_size || rounds <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    int ok = 1;
+    int ran = 0;
+    for (size_t s = 0; s < sizeof(shapes) / sizeof(shapes[0]); s++) {
+        if (only && strcmp(only, shapes[s].name) != 0) {
+            continue;
+        }
+        ran = 1;
+        for (long long size = min_size; size <= max_size; size *= 4) {
+            ok &= measure_isolated(&shapes[s], size, rounds);
+        }
+    }
+    if (!ran) {
+        usage(argv[0]);
+        return 2;
+    }
+    return ok ? 0 : 1;
+}
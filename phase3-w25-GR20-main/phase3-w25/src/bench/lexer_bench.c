@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../../include/lexer.h"
+
+// -----------------------------------------------------------------
+// Lexer throughput benchmark: tokenizes a synthetic program with the
+// scalar loops and with the SIMD fast paths and reports tokens/s.
+// usage: lexer_bench [megabytes] [rounds]
+// -----------------------------------------------------------------
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Build roughly `size` bytes of valid source: declarations, loops with
+// long identifiers, indentation and block comments.
+static char* generate_source(size_t size) {
+    static const char* pieces[] = {
+        "int accumulated_total_value_%d;\n",
+        "    accumulated_total_value_%d = 1234567890 + counter_variable * 42;\n",
+        "        if (counter_variable <= %d) { print counter_variable; }\n",
+        "/* running sum for block %d, recomputed on every iteration of the loop */\n",
+        "    while (counter_variable != %d) { counter_variable = counter_variable - 1; }\n",
+        "\t\tprint factorial(%d);\n"
+    };
+    char* text = malloc(size + 128);
+    if (!text) {
+        return NULL;
+    }
+    size_t used = 0;
+    for (int i = 0; used < size; i++) {
+        used += (size_t)sprintf(text + used, pieces[i % 6], i);
+    }
+    return text;
+}
+
+// Lex the whole text once; returns the token count.
+static long lex_all(const char* text, InternTable* table, int scalar_only) {
+    Lexer lexer;
+    lexer_init(&lexer, text, table);
+    lexer.scalar_only = scalar_only;
+    long count = 0;
+    while (lexer_next_token(&lexer).type != TOKEN_EOF) {
+        count++;
+    }
+    return count;
+}
+
+// Best-of-`rounds` seconds for one full pass.
+static double time_pass(const char* text, InternTable* table, int scalar_only, int rounds, long* tokens) {
+    double best = 0.0;
+    for (int r = 0; r < rounds; r++) {
+        double start = now_seconds();
+        *tokens = lex_all(text, table, scalar_only);
+        double elapsed = now_seconds() - start;
+        if (r == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    size_t megabytes = argc > 1 ? (size_t)atoi(argv[1]) : 16;
+    int rounds = argc > 2 ? atoi(argv[2]) : 5;
+    if (megabytes == 0 || rounds <= 0) {
+        fprintf(stderr, "usage: %s [megabytes] [rounds]\n", argv[0]);
+        return 2;
+    }
+    char* text = generate_source(megabytes << 20);
+    if (!text) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    size_t bytes = strlen(text);
+
+    InternTable table;
+    if (!lexer_init_strings(&table)) {
+        fprintf(stderr, "out of memory\n");
+        free(text);
+        return 1;
+    }
+    lex_all(text, &table, 1);  // Warm up and intern every lexeme once
+
+    long scalar_tokens, fast_tokens;
+    double scalar = time_pass(text, &table, 1, rounds, &scalar_tokens);
+    double fast = time_pass(text, &table, 0, rounds, &fast_tokens);
+    if (scalar_tokens != fast_tokens) {
+        fprintf(stderr, "token count mismatch: scalar %ld, fast path %ld\n", scalar_tokens, fast_tokens);
+        return 1;
+    }
+
+    printf("%zu bytes, %ld tokens, best of %d\n", bytes, fast_tokens, rounds);
+    printf("scalar:    %8.3f s  %8.2f Mtokens/s  %8.1f MB/s\n",
+           scalar, scalar_tokens / scalar / 1e6, bytes / scalar / 1e6);
+    printf("fast path: %8.3f s  %8.2f Mtokens/s  %8.1f MB/s  (%.2fx)\n",
+           fast, fast_tokens / fast / 1e6, bytes / fast / 1e6, scalar / fast);
+
+    intern_free(&table);
+    free(text);
+    return 0;
+}
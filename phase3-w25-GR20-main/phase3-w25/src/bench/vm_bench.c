@@ -0,0 +1,136 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../../include/parser.h"
+#include "../../include/semantic.h"
+#include "../../include/interpreter.h"
+#include "../../include/bytecode.h"
+#include "../../include/jit.h"
+
+// -----------------------------------------------------------------
+// Execution benchmark: runs loop-heavy programs on the tree-walking
+// interpreter, on the bytecode VM and on the VM with the loop JIT, checks
+// that all of them print the same output, and reports the time of each.
+// usage: vm_bench [iterations] [rounds]
+// -----------------------------------------------------------------
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+typedef struct {
+    const char* name;
+    const char* source;       // printf format taking the iteration count
+} Workload;
+
+static const Workload workloads[] = {
+    {"sum loop",
+     "int i; int s; i = 0; s = 0;\n"
+     "while (i < %ld) { s = s + i * 3 - i / 7; i = i + 1; }\n"
+     "print s;\n"},
+    {"nested loops",
+     "int i; int n; int c; n = %ld / 1000; i = 0; c = 0;\n"
+     "while (i < n) { int j; j = 0;\n"
+     "  while (j < 1000) { if (j > 500) { c = c + 1; } j = j + 1; }\n"
+     "  i = i + 1; }\n"
+     "print c;\n"},
+    {"repeat + factorial",
+     "int k; int t; k = 0; t = 0;\n"
+     "repeat { t = t + factorial(k / 100000 + 3) - k; k = k + 1; } until (k == %ld);\n"
+     "print t;\n"},
+};
+
+typedef enum { ENGINE_TREE, ENGINE_VM, ENGINE_JIT } Engine;
+
+// Run one engine `rounds` times; returns the best time and leaves the
+// output of the last run in *output.
+static double time_engine(Engine engine, ASTNode* ast, const Chunk* chunk, int slot_count,
+                          int rounds, char** output) {
+    double best = 0.0;
+    for (int r = 0; r < rounds; r++) {
+        FILE* out = tmpfile();
+        if (!out) {
+            perror("tmpfile");
+            exit(1);
+        }
+        double start = now_seconds();
+        if (engine == ENGINE_JIT) {
+            vm_run_jit(chunk, out, JIT_DEFAULT_THRESHOLD);
+        } else if (engine == ENGINE_VM) {
+            vm_run(chunk, out);
+        } else {
+            interpret(ast, slot_count, out);
+        }
+        double elapsed = now_seconds() - start;
+        if (r == 0 || elapsed < best) {
+            best = elapsed;
+        }
+        long size = ftell(out);
+        free(*output);
+        *output = calloc((size_t)size + 1, 1);
+        rewind(out);
+        if (*output && size > 0 && fread(*output, 1, (size_t)size, out) != (size_t)size) {
+            (*output)[0] = '\0';
+        }
+        fclose(out);
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    long iterations = argc > 1 ? atol(argv[1]) : 5000000;
+    int rounds = argc > 2 ? atoi(argv[2]) : 3;
+    if (iterations <= 0 || rounds <= 0) {
+        fprintf(stderr, "usage: %s [iterations] [rounds]\n", argv[0]);
+        return 2;
+    }
+
+    int failed = 0;
+    if (!jit_available()) {
+        printf("(no JIT backend for this target; the jit column runs the plain VM)\n");
+    }
+    printf("%-20s %12s %12s %12s %8s %8s\n", "workload", "tree (s)", "vm (s)", "jit (s)",
+           "vm gain", "jit gain");
+    for (size_t w = 0; w < sizeof(workloads) / sizeof(workloads[0]); w++) {
+        char source[1024];
+        snprintf(source, sizeof(source), workloads[w].source, iterations);
+
+        Parser parser = {0};
+        int lexed = parser_context_init(&parser, source);
+        ASTNode* ast = lexed ? parser_context_parse(&parser) : NULL;
+        diagnostics_print(parser.diagnostics.items, parser.diagnostics.count, DIAGNOSTICS_TEXT, NULL,
+                          stdout);
+        int slot_count = 0;
+        Chunk chunk;
+        if (!ast || !analyze_semantics_slots(ast, stderr, 0, &slot_count) ||
+            !bytecode_compile(ast, slot_count, &chunk)) {
+            fprintf(stderr, "%s: failed to compile\n", workloads[w].name);
+            parser_context_destroy(&parser);
+            return 1;
+        }
+
+        char* tree_output = NULL;
+        char* vm_output = NULL;
+        char* jit_output = NULL;
+        double tree = time_engine(ENGINE_TREE, ast, &chunk, slot_count, rounds, &tree_output);
+        double vm = time_engine(ENGINE_VM, ast, &chunk, slot_count, rounds, &vm_output);
+        double jit = time_engine(ENGINE_JIT, ast, &chunk, slot_count, rounds, &jit_output);
+        printf("%-20s %12.3f %12.3f %12.3f %7.2fx %7.2fx\n", workloads[w].name, tree, vm, jit,
+               tree / vm, vm / jit);
+        if (!tree_output || !vm_output || !jit_output || strcmp(tree_output, vm_output) != 0 ||
+            strcmp(vm_output, jit_output) != 0) {
+            fprintf(stderr, "%s: engines disagree\n", workloads[w].name);
+            failed = 1;
+        }
+
+        free(tree_output);
+        free(vm_output);
+        free(jit_output);
+        chunk_free(&chunk);
+        parser_context_destroy(&parser);
+    }
+    return failed;
+}
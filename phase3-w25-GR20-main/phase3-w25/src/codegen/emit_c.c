@@ -0,0 +1,225 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include "../../include/codegen.h"
+#include "../../include/interpreter.h"
+
+// -----------------------------------------------------------------
+// C emission. Expressions are printed fully parenthesized; arithmetic
+// goes through small inline helpers that wrap around on overflow (the
+// interpreter's semantics), which the C compiler reduces to single
+// instructions. Statement lists are walked iteratively.
+// -----------------------------------------------------------------
+
+typedef struct {
+    FILE* out;
+    int indent;
+    int ok;
+} Emitter;
+
+static void emit_statement(Emitter* e, ASTNode* node);
+
+static const char* runtime_prelude =
+    "#include <stdio.h>\n"
+    "#include <stdlib.h>\n"
+    "\n"
+    "typedef long long Value;\n"
+    "typedef unsigned long long Bits;\n"
+    "\n"
+    "static inline Value mc_add(Value a, Value b) { return (Value)((Bits)a + (Bits)b); }\n"
+    "static inline Value mc_sub(Value a, Value b) { return (Value)((Bits)a - (Bits)b); }\n"
+    "static inline Value mc_mul(Value a, Value b) { return (Value)((Bits)a * (Bits)b); }\n"
+    "static Value mc_div(Value a, Value b, int line) {\n"
+    "    if (b == 0) {\n"
+    "        printf(\"Runtime Error at line %d: Division by zero\\n\", line);\n"
+    "        exit(1);\n"
+    "    }\n"
+    "    return b == -1 ? mc_sub(0, a) : a / b;\n"
+    "}\n"
+    "static Value mc_factorial(Value n) {\n"
+    "    Value result = 1;\n"
+    "    for (Value i = 2; i <= n; i++) {\n"
+    "        result = mc_mul(result, i);\n"
+    "    }\n"
+    "    return result;\n"
+    "}\n"
+    "\n";
+
+static void emit_indent(Emitter* e) {
+    for (int i = 0; i < e->indent; i++) {
+        fputs("    ", e->out);
+    }
+}
+
+// Resolved variable of a declaration or identifier.
+static void emit_variable(Emitter* e, const ASTNode* node) {
+    if (node->slot < 0) {
+        e->ok = 0;
+    }
+    fprintf(e->out, "v%d", node->slot);
+}
+
+static void emit_expression(Emitter* e, ASTNode* node) {
+    if (!node) {
+        e->ok = 0;
+        return;
+    }
+    switch (node->type) {
+        case AST_NUMBER: {
+            Value value = node->token.value;
+            if (value == LLONG_MIN) {
+                fputs("(-9223372036854775807LL - 1)", e->out);
+            } else {
+                fprintf(e->out, value < 0 ? "(%lldLL)" : "%lldLL", value);
+            }
+            break;
+        }
+        case AST_IDENTIFIER:
+            emit_variable(e, node);
+            break;
+        case AST_FUNCALL:
+            fputs("mc_factorial(", e->out);
+            emit_expression(e, node->left);
+            fputs(")", e->out);
+            break;
+        case AST_BINOP: {
+            const char* call = NULL;
+            const char* infix = NULL;
+            switch (node->token.id) {
+                case LEXEME_PLUS:  call = "mc_add"; break;
+                case LEXEME_MINUS: call = "mc_sub"; break;
+                case LEXEME_STAR:  call = "mc_mul"; break;
+                case LEXEME_SLASH: call = "mc_div"; break;
+                case LEXEME_LT:    infix = " < "; break;
+                case LEXEME_GT:    infix = " > "; break;
+                case LEXEME_LE:    infix = " <= "; break;
+                case LEXEME_GE:    infix = " >= "; break;
+                case LEXEME_EQ:    infix = " == "; break;
+                case LEXEME_NE:    infix = " != "; break;
+                default:           e->ok = 0; return;
+            }
+            if (call) {
+                fprintf(e->out, "%s(", call);
+                emit_expression(e, node->left);
+                fputs(", ", e->out);
+                emit_expression(e, node->right);
+                if (node->token.id == LEXEME_SLASH) {
+                    fprintf(e->out, ", %d", node->token.line);
+                }
+                fputs(")", e->out);
+            } else {
+                fputs("(Value)(", e->out);
+                emit_expression(e, node->left);
+                fputs(infix, e->out);
+                emit_expression(e, node->right);
+                fputs(")", e->out);
+            }
+            break;
+        }
+        default:
+            e->ok = 0;
+            break;
+    }
+}
+
+// Emit a statement as the body of a control construct, always braced.
+static void emit_body(Emitter* e, ASTNode* node) {
+    fputs("{\n", e->out);
+    e->indent++;
+    emit_statement(e, node);
+    e->indent--;
+    emit_indent(e);
+    fputs("}", e->out);
+}
+
+// Emit every statement of an AST_PROGRAM or AST_BLOCK.
+static void emit_children(Emitter* e, ASTNode* node) {
+    for (int i = 0; i < node->child_count; i++) {
+        emit_statement(e, node->children[i]);
+    }
+}
+
+static void emit_statement(Emitter* e, ASTNode* node) {
+    if (!node) {
+        return;
+    }
+    switch (node->type) {
+        case AST_PROGRAM:
+            emit_children(e, node);
+            break;
+        case AST_BLOCK:
+            emit_indent(e);
+            fputs("{\n", e->out);
+            e->indent++;
+            emit_children(e, node);
+            e->indent--;
+            emit_indent(e);
+            fputs("}\n", e->out);
+            break;
+        case AST_VARDECL:
+            emit_indent(e);
+            emit_variable(e, node);
+            fputs(" = 0;\n", e->out);
+            break;
+        case AST_ASSIGN:
+            emit_indent(e);
+            emit_variable(e, node->left);
+            fputs(" = ", e->out);
+            emit_expression(e, node->right);
+            fputs(";\n", e->out);
+            break;
+        case AST_PRINT:
+            emit_indent(e);
+            fputs("printf(\"%lld\\n\", ", e->out);
+            emit_expression(e, node->left);
+            fputs(");\n", e->out);
+            break;
+        case AST_IF:
+            emit_indent(e);
+            fputs("if (", e->out);
+            emit_expression(e, node->left);
+            fputs(") ", e->out);
+            emit_body(e, node->right);
+            if (node->else_branch) {
+                fputs(" else ", e->out);
+                emit_body(e, node->else_branch);
+            }
+            fputs("\n", e->out);
+            break;
+        case AST_WHILE:
+            emit_indent(e);
+            fputs("while (", e->out);
+            emit_expression(e, node->left);
+            fputs(") ", e->out);
+            emit_body(e, node->right);
+            fputs("\n", e->out);
+            break;
+        case AST_REPEAT:
+            emit_indent(e);
+            fputs("do ", e->out);
+            emit_body(e, node->left);
+            fputs(" while (!", e->out);
+            emit_expression(e, node->right);
+            fputs(");\n", e->out);
+            break;
+        default:
+            emit_indent(e);
+            fputs("(void)", e->out);
+            emit_expression(e, node);
+            fputs(";\n", e->out);
+            break;
+    }
+}
+
+int codegen_emit_c(ASTNode* program, int slot_count, FILE* out) {
+    Emitter e = {out, 1, 1};
+    fputs("/* Generated by minicc. */\n", out);
+    fputs(runtime_prelude, out);
+    fputs("int main(void) {\n", out);
+    for (int i = 0; i < slot_count; i++) {
+        fprintf(out, "    Value v%d = 0;\n", i);
+    }
+    emit_statement(&e, program);
+    fputs("    return 0;\n}\n", out);
+    return e.ok;
+}
@@ -0,0 +1,403 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include "../../include/parser.h"
+#include "../../include/semantic.h"
+#include "../../include/diagnostics.h"
+#include "../../include/source.h"
+#include "../../include/thread_pool.h"
+#include "../../include/bytecode_cache.h"
+#include "../../include/optimizer.h"
+#include "../../include/pipeline.h"
+#include "../../include/parallel_check.h"
+#include "../../include/stats.h"
+
+// -----------------------------------------------------------------
+// Batch compile driver: lex -> parse -> semantic analysis for many files,
+// one file per job on a work-stealing pool. Each job owns its Parser
+// context and writes diagnostics to a private buffer, and results are
+// reported in input order so the output does not depend on scheduling.
+// With --cache, files whose compiled image is already cached skip the
+// front end entirely, and successful compiles are added to the cache.
+// With --pipeline, each file's lexer, parser and checker run concurrently.
+// With --parallel-check, each file's top-level blocks are checked on a pool.
+// --diagnostics picks how errors are printed; in JSON mode stdout carries
+// only the JSON lines, and the per-file status and summary go to stderr.
+// --stats adds the phase timers and counters of all files to the summary.
+// -----------------------------------------------------------------
+
+typedef enum {
+    RESULT_OK,
+    RESULT_READ_ERROR,
+    RESULT_SYNTAX_ERROR,
+    RESULT_SEMANTIC_ERROR,
+    RESULT_NO_MEMORY
+} FileStatus;
+
+typedef struct {
+    const char* path;
+    FileStatus status;
+    size_t bytes;             // Size of the source
+    int tokens;               // Tokens lexed (including EOF)
+    int cached;               // 1 if the result came from the bytecode cache
+    int syntax_errors;        // Syntax errors the parser recovered from
+    char* diagnostics;        // This file's diagnostics, formatted
+    FrontendStats stats;      // What its compile counted
+} FileResult;
+
+typedef struct {
+    char** items;
+    int count;
+    int capacity;
+} PathList;
+
+typedef struct {
+    FileResult* results;
+    const char* cache_dir;    // Bytecode cache directory (NULL = no cache)
+    int pipeline;             // Run each file through pipeline_run
+    int check_threads;        // Threads for analyze_semantics_parallel (1 = serial check)
+    DiagnosticFormat format;  // How diagnostics are printed
+} Batch;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void add_path(PathList* list, const char* path) {
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 64;
+        char** items = realloc(list->items, capacity * sizeof(char*));
+        if (!items) {
+            perror("Memory allocation failed");
+            exit(1);
+        }
+        list->items = items;
+        list->capacity = capacity;
+    }
+    size_t length = strlen(path);
+    char* copy = malloc(length + 1);
+    if (!copy) {
+        perror("Memory allocation failed");
+        exit(1);
+    }
+    memcpy(copy, path, length + 1);
+    list->items[list->count++] = copy;
+}
+
+static int compare_paths(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+// Add every regular file in `dir` (non-recursive), sorted by name so the
+// report order is reproducible.
+static int add_directory(PathList* list, const char* dir) {
+    DIR* handle = opendir(dir);
+    if (!handle) {
+        perror(dir);
+        return 0;
+    }
+    int first = list->count;
+    struct dirent* entry;
+    while ((entry = readdir(handle)) != NULL) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+        DIR* sub = opendir(path);
+        if (sub) {
+            closedir(sub);  // Skip subdirectories
+            continue;
+        }
+        add_path(list, path);
+    }
+    closedir(handle);
+    qsort(list->items + first, list->count - first, sizeof(char*), compare_paths);
+    return 1;
+}
+
+// Add one path per non-empty line of the manifest file.
+static int add_manifest(PathList* list, const char* manifest) {
+    FILE* file = fopen(manifest, "r");
+    if (!file) {
+        perror(manifest);
+        return 0;
+    }
+    char line[4096];
+    while (fgets(line, sizeof(line), file)) {
+        size_t length = strcspn(line, "\r\n");
+        line[length] = '\0';
+        if (length > 0) {
+            add_path(list, line);
+        }
+    }
+    fclose(file);
+    return 1;
+}
+
+// Slurp a temporary stream into a heap string and close it.
+static char* drain_stream(FILE* stream) {
+    long size = ftell(stream);
+    char* text = malloc(size > 0 ? size + 1 : 1);
+    if (text) {
+        rewind(stream);
+        size_t read = size > 0 ? fread(text, 1, size, stream) : 0;
+        text[read] = '\0';
+    }
+    fclose(stream);
+    return text;
+}
+
+// The records as text, for the cache (which replays text diagnostics).
+static char* format_text(const DiagnosticList* list) {
+    char* text = NULL;
+    size_t size = 0;
+    FILE* stream = open_memstream(&text, &size);
+    if (!stream) {
+        return NULL;
+    }
+    diagnostics_print(list->items, list->count, DIAGNOSTICS_TEXT, NULL, stream);
+    fclose(stream);
+    return text;
+}
+
+// Pool job: run the whole front end for one file.
+static void compile_file(void* context, int job) {
+    Batch* batch = context;
+    FileResult* result = &batch->results[job];
+    FILE* diagnostics = tmpfile();
+    if (!diagnostics) {
+        diagnostics = stdout;  // Fall back to unordered output
+    }
+
+    SourceFile source;
+    CachedProgram cached;
+    Chunk chunk = {0};
+    int store = 0;
+    char* cache_text = NULL;  // Text diagnostics to store with the image
+    int opened = source_open(&source, result->path);
+    int hit = 0;
+    if (opened && batch->cache_dir &&
+        bytecode_cache_load(batch->cache_dir, source.data, source.size, &cached)) {
+        // Cached text cannot be turned back into JSON records: recompile instead.
+        hit = batch->format != DIAGNOSTICS_JSON || cached.diagnostics[0] == '\0';
+        if (!hit) {
+            bytecode_cache_close(&cached);
+        }
+    }
+    if (!opened) {
+        result->status = RESULT_READ_ERROR;
+    } else if (hit) {
+        result->bytes = source.size;
+        result->tokens = cached.tokens;
+        result->status = RESULT_OK;
+        result->cached = 1;
+        if (batch->format == DIAGNOSTICS_TEXT) {
+            fputs(cached.diagnostics, diagnostics);  // Replay the warnings of the original compile
+        }
+        bytecode_cache_close(&cached);
+    } else {
+        result->bytes = source.size;
+        Parser parser = {0};
+        DiagnosticList semantic = {0};
+        PipelineResult run;
+        ASTNode* ast;
+        int slot_count = 0;
+        int valid;
+        int lexed = 1;  // 0 if the lexer ran out of memory
+        if (batch->pipeline && pipeline_run(&parser, source.data, &semantic, &run)) {
+            result->tokens = run.tokens;
+            result->syntax_errors = run.syntax_errors;
+            ast = run.syntax_errors ? NULL : run.program;
+            valid = run.valid;
+            slot_count = run.slot_count;
+        } else {
+            lexed = parser_context_init(&parser, source.data);
+            result->tokens = parser.owned_tokens.count;
+            ast = lexed ? parser_context_parse(&parser) : NULL;
+            result->syntax_errors = parser.diagnostics.count;
+            valid = ast && analyze_semantics_parallel(ast, &semantic, &slot_count,
+                                                     batch->check_threads);
+        }
+        // Syntax errors first, as the front end finds them; the lexemes
+        // live in the parser's string table, so format before destroying it.
+        diagnostics_append(&parser.diagnostics, semantic.items, semantic.count);
+        diagnostics_print(parser.diagnostics.items, parser.diagnostics.count, batch->format,
+                          result->path, diagnostics);
+        if (!lexed) {
+            result->status = RESULT_NO_MEMORY;
+        } else if (!ast) {
+            result->status = RESULT_SYNTAX_ERROR;
+        } else if (!valid) {
+            result->status = RESULT_SEMANTIC_ERROR;
+        } else {
+            result->status = RESULT_OK;
+            if (batch->cache_dir && diagnostics != stdout) {
+                fold_constants(ast, &parser.strings, NULL);
+                cache_text = format_text(&parser.diagnostics);
+                store = cache_text && bytecode_compile(ast, slot_count, &chunk);
+            }
+        }
+        diagnostics_free(&semantic);
+        parser_context_destroy(&parser);
+    }
+
+    if (diagnostics != stdout) {
+        result->diagnostics = drain_stream(diagnostics);
+    }
+    if (store) {
+        bytecode_cache_store(batch->cache_dir, source.data, source.size, &chunk,
+                             result->tokens, cache_text);
+        chunk_free(&chunk);
+    }
+    free(cache_text);
+    if (result->status != RESULT_READ_ERROR) {
+        source_close(&source);
+    }
+    stats_take(&result->stats);
+}
+
+static const char* status_text(FileStatus status) {
+    switch (status) {
+        case RESULT_OK:             return "ok";
+        case RESULT_READ_ERROR:     return "unreadable";
+        case RESULT_SYNTAX_ERROR:   return "syntax errors";
+        case RESULT_SEMANTIC_ERROR: return "semantic errors";
+        case RESULT_NO_MEMORY:      return "out of memory";
+        default:                    return "unknown";
+    }
+}
+
+static void usage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s [-j threads] [--cache DIR] [--pipeline] [--parallel-check] [--diagnostics FORMAT] [--stats | --stats-json] [--dir DIR] [--manifest FILE] [file...]\n"
+            "  -j N           worker threads (default: number of CPUs)\n"
+            "  --cache DIR    reuse and update compiled images in DIR\n"
+            "  --pipeline     lex, parse and check each file on three threads at once\n"
+            "  --parallel-check  check each file's top-level blocks on its share of the -j threads\n"
+            "  --diagnostics F  print errors as text (default), json or quiet\n"
+            "  --stats        report phase times and front end counters\n"
+            "  --stats-json   the same report as one JSON object\n"
+            "  --dir DIR      compile every file in DIR\n"
+            "  --manifest F   compile every path listed in F, one per line\n",
+            program);
+}
+
+int main(int argc, char** argv) {
+    PathList paths = {0};
+    int threads = thread_pool_default_threads();
+    const char* cache_dir = NULL;
+    int pipeline = 0;
+    int parallel_check = 0;
+    DiagnosticFormat format = DIAGNOSTICS_TEXT;
+    int stats = -1;  // 0 = table, 1 = JSON
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            cache_dir = argv[++i];
+        } else if (strcmp(argv[i], "--pipeline") == 0) {
+            pipeline = 1;
+        } else if (strcmp(argv[i], "--parallel-check") == 0) {
+            parallel_check = 1;
+        } else if (strcmp(argv[i], "--diagnostics") == 0 && i + 1 < argc) {
+            if (!diagnostics_format_from_name(argv[++i], &format)) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            stats = 0;
+        } else if (strcmp(argv[i], "--stats-json") == 0) {
+            stats = 1;
+        } else if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+            if (!add_directory(&paths, argv[++i])) return 1;
+        } else if (strcmp(argv[i], "--manifest") == 0 && i + 1 < argc) {
+            if (!add_manifest(&paths, argv[++i])) return 1;
+        } else if (argv[i][0] == '-') {
+            usage(argv[0]);
+            return 1;
+        } else {
+            add_path(&paths, argv[i]);
+        }
+    }
+    if (paths.count == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    Batch batch;
+    batch.cache_dir = cache_dir;
+    batch.pipeline = pipeline;
+    // The file pool runs up to `threads` files at once; share the threads
+    // among them rather than giving every file's check a pool of its own.
+    int file_workers = paths.count < threads ? paths.count : threads;
+    int check_threads = file_workers > 0 ? threads / file_workers : 1;
+    batch.check_threads = parallel_check && check_threads > 1 ? check_threads : 1;
+    batch.format = format;
+    batch.results = calloc(paths.count, sizeof(FileResult));
+    if (!batch.results) {
+        perror("Memory allocation failed");
+        return 1;
+    }
+    for (int i = 0; i < paths.count; i++) {
+        batch.results[i].path = paths.items[i];
+    }
+
+    double start = now_seconds();
+    thread_pool_run(paths.count, threads, compile_file, &batch);
+    double elapsed = now_seconds() - start;
+
+    // Report in input order.
+    FILE* report = format == DIAGNOSTICS_JSON ? stderr : stdout;
+    int failed = 0;
+    size_t total_bytes = 0;
+    long total_tokens = 0;
+    int cache_hits = 0;
+    FrontendStats totals = {0};
+    for (int i = 0; i < paths.count; i++) {
+        FileResult* result = &batch.results[i];
+        if (result->diagnostics && result->diagnostics[0]) {
+            if (format == DIAGNOSTICS_JSON) {
+                fputs(result->diagnostics, stdout);  // Each line names its file
+            } else {
+                printf("%s:\n%s", result->path, result->diagnostics);
+            }
+        }
+        if (result->status == RESULT_SYNTAX_ERROR) {
+            fprintf(report, "%s: %s (%d)\n", result->path, status_text(result->status), result->syntax_errors);
+        } else {
+            fprintf(report, "%s: %s\n", result->path, status_text(result->status));
+        }
+        failed += result->status != RESULT_OK;
+        total_bytes += result->bytes;
+        total_tokens += result->tokens;
+        cache_hits += result->cached;
+        stats_add(&totals, &result->stats);
+        free(result->diagnostics);
+    }
+
+    if (elapsed <= 0) elapsed = 1e-9;
+    fprintf(report, "\n%d files (%d ok, %d failed), %zu bytes, %ld tokens in %.3f s on %d threads\n",
+           paths.count, paths.count - failed, failed, total_bytes, total_tokens, elapsed,
+           threads < paths.count ? threads : paths.count);
+    if (cache_dir) {
+        fprintf(report, "Cache: %d of %d files loaded from %s\n", cache_hits, paths.count, cache_dir);
+    }
+    fprintf(report, "Throughput: %.1f files/s, %.2f MB/s\n",
+           paths.count / elapsed, total_bytes / (1024.0 * 1024.0) / elapsed);
+    if (stats >= 0) {
+        stats_print(&totals, stats, report);
+    }
+
+    for (int i = 0; i < paths.count; i++) {
+        free(paths.items[i]);
+    }
+    free(paths.items);
+    free(batch.results);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/incremental.h"
+#include "../../include/parser.h"
+#include "../../include/semantic.h"
+#include "../../include/source.h"
+
+// -----------------------------------------------------------------
+// Incremental front end check: applies random edits to each file through
+// a Document and, after every edit, compares document_diagnostics with
+// what a fresh parse and check of the whole text reports. Exits with
+// status 1 on the first file whose diagnostics differ.
+// usage: editcheck [--edits N] [--seed N] file...
+// -----------------------------------------------------------------
+
+// Fragments inserted by the edits: whole statements, and pieces that
+// split tokens, open comments or leave statements unfinished.
+static const char* const fragments[] = {
+    "x", "y", ";", "{", "}", "(", ")", "+", "==", "= ", "1", "int", " ", "\n", "\n\n", "\r\n",
+    "/*", "*/", "//", "int x;", "int z;", "x = y;", "z = 1;", "print x;", "factorial(",
+    "if (x < 3) { y = 2; }", "while (y) { int q; q = y; }", "repeat { x = 1; } until (x);",
+};
+
+#define FRAGMENT_COUNT ((unsigned int)(sizeof(fragments) / sizeof(fragments[0])))
+#define MAX_DELETE 40
+
+static unsigned int next_random(unsigned int* state) {
+    *state = *state * 1103515245u + 12345u;
+    return *state >> 8;
+}
+
+// Diagnostics of a full parse and, if it found no syntax errors, a full
+// check. Returns 0 if the lexer ran out of memory.
+static int full_diagnostics(const char* text, DiagnosticList* out) {
+    Parser parser;
+    memset(&parser, 0, sizeof(parser));
+    if (!parser_context_init(&parser, text)) {
+        parser_context_destroy(&parser);
+        return 0;
+    }
+    ASTNode* ast = parser_context_parse_partial(&parser);
+    diagnostics_append(out, parser.diagnostics.items, parser.diagnostics.count);
+    if (parser.diagnostics.count == 0) {
+        analyze_semantics_record(ast, out, NULL);
+    }
+    // Keep the lexemes: they are compared after the parser is gone.
+    for (int i = 0; i < out->count; i++) {
+        out->items[i].lexeme = strdup(out->items[i].lexeme);
+    }
+    parser_context_destroy(&parser);
+    return 1;
+}
+
+static void free_lexemes(DiagnosticList* list) {
+    for (int i = 0; i < list->count; i++) {
+        free((char*)list->items[i].lexeme);
+    }
+}
+
+static int same_diagnostics(const DiagnosticList* a, const DiagnosticList* b) {
+    if (a->count != b->count) {
+        return 0;
+    }
+    for (int i = 0; i < a->count; i++) {
+        const Diagnostic* x = &a->items[i];
+        const Diagnostic* y = &b->items[i];
+        if (x->phase != y->phase || x->code != y->code || x->line != y->line ||
+            x->column != y->column || strcmp(x->lexeme ? x->lexeme : "", y->lexeme ? y->lexeme : "") != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Edit `doc` `edits` times; returns 0 and reports the first mismatch.
+static int check_file(const char* path, Document* doc, int edits, unsigned int* seed,
+                      size_t* relexed, size_t* total) {
+    for (int e = 0; e < edits; e++) {
+        size_t length = document_length(doc);
+        size_t start = next_random(seed) % (length + 1);
+        size_t end = start;
+        if (next_random(seed) % 4 == 0) {
+            end += next_random(seed) % MAX_DELETE;
+            if (end > length) end = length;
+        }
+        const char* text = next_random(seed) % 5 == 0 ? "" : fragments[next_random(seed) % FRAGMENT_COUNT];
+        if (!document_edit(doc, start, end, text, strlen(text))) {
+            fprintf(stderr, "%s: edit %d failed (out of memory)\n", path, e + 1);
+            return 0;
+        }
+        *relexed += document_last_edit(doc).relexed_bytes;
+        *total += document_length(doc);
+
+        DiagnosticList got = {0};
+        DiagnosticList want = {0};
+        document_diagnostics(doc, &got);
+        if (!full_diagnostics(document_text(doc), &want)) {
+            fprintf(stderr, "%s: full parse after edit %d failed (out of memory)\n", path, e + 1);
+            diagnostics_free(&got);
+            return 0;
+        }
+        int same = same_diagnostics(&got, &want);
+        if (!same) {
+            printf("%s: edit %d replaced [%zu, %zu) with \"%s\"; diagnostics differ\n", path, e + 1,
+                   start, end, text);
+            printf("--- text\n%s\n--- incremental\n", document_text(doc));
+            diagnostics_print(got.items, got.count, DIAGNOSTICS_TEXT, NULL, stdout);
+            printf("--- full\n");
+            diagnostics_print(want.items, want.count, DIAGNOSTICS_TEXT, NULL, stdout);
+        }
+        free_lexemes(&want);
+        diagnostics_free(&got);
+        diagnostics_free(&want);
+        if (!same) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+    int edits = 200;
+    unsigned int seed = 1;
+    int first_file = 1;
+    while (first_file < argc && argv[first_file][0] == '-') {
+        if (strcmp(argv[first_file], "--edits") == 0 && first_file + 1 < argc) {
+            edits = atoi(argv[first_file + 1]);
+        } else if (strcmp(argv[first_file], "--seed") == 0 && first_file + 1 < argc) {
+            seed = (unsigned int)strtoul(argv[first_file + 1], NULL, 10);
+        } else {
+            first_file = argc;
+            break;
+        }
+        first_file += 2;
+    }
+    if (first_file >= argc || edits < 0) {
+        fprintf(stderr, "Usage: %s [--edits N] [--seed N] file...\n", argv[0]);
+        return 1;
+    }
+
+    int checked = 0;
+    size_t relexed = 0;
+    size_t total = 0;
+    for (int i = first_file; i < argc; i++) {
+        char* source = read_file(argv[i]);
+        if (!source) {
+            return 1;
+        }
+        Document* doc = document_open(source);
+        free(source);
+        if (!doc) {
+            fprintf(stderr, "%s: out of memory\n", argv[i]);
+            return 1;
+        }
+        int ok = check_file(argv[i], doc, edits, &seed, &relexed, &total);
+        document_close(doc);
+        if (!ok) {
+            return 1;
+        }
+        checked += edits;
+    }
+    printf("%d edits in %d files, diagnostics match a full parse and check; relexed %.1f%% of the text\n",
+           checked, argc - first_file, total ? 100.0 * (double)relexed / (double)total : 0.0);
+    return 0;
+}
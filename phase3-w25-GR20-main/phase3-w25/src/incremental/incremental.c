@@ -0,0 +1,728 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/incremental.h"
+#include "../../include/lexer.h"
+#include "../../include/ast_visit.h"
+#include "../../include/semantic.h"
+#include "../../include/arena.h"
+
+// -----------------------------------------------------------------
+// Document model: the text is tiled by top-level statements ("units").
+// A unit spans from the end of the previous one to the end of its own
+// last token, so the whitespace and comments in front of a statement
+// belong to it; whatever follows the last statement belongs to none.
+// -----------------------------------------------------------------
+
+// Effect of a top-level statement on a global, as its check left it.
+enum {
+    EFFECT_DECLARE = 1,       // Declares the name at global scope
+    EFFECT_INITIALIZE = 2     // Assigns the global declared under the name
+};
+
+typedef struct {
+    unsigned int name;        // Intern ID
+    int kinds;                // EFFECT_* bits
+} Effect;
+
+// Arena holding the trees of one reparse; freed with its last statement.
+typedef struct {
+    Arena arena;
+    int refs;                 // Units whose tree lives here
+} Generation;
+
+typedef struct {
+    struct Unit **items;
+    int count;
+    int capacity;
+} UnitList;
+
+typedef struct Unit {
+    int index;                // Position in the document
+    size_t end;               // Offset just past the last token
+    int line;                 // Line of the last token
+    int line_shift;           // Lines inserted above since the tree and diagnostics were made
+    int clean;                // Parsed without syntax errors
+    ASTNode *statement;       // NULL after a syntax error
+    Generation *generation;
+    Diagnostic *syntax;       // Syntax errors of the statement
+    int syntax_count;
+    Diagnostic *semantic;     // Semantic errors of its last check
+    int semantic_count;
+    unsigned int *names;      // Distinct identifiers the statement mentions
+    int name_count;
+    Effect *effects;          // Globals the statement declares or initializes
+    int effect_count;
+    int queued;               // Waiting in the recheck queue
+} Unit;
+
+// Per intern ID: which statements use the name and which change it.
+typedef struct {
+    UnitList readers;         // Units mentioning the name
+    UnitList writers;         // Units with an effect on it
+    int seen;                 // Stamp for collecting a unit's names
+    int stamp;                // Stamp for comparing effects
+    int kinds[2];             // Effects before / after, while comparing
+} NameInfo;
+
+struct Document {
+    char *text;               // Always NUL-terminated
+    size_t length;
+    size_t capacity;
+    InternTable strings;      // Lexemes of every version of the text
+    TokenBuffer tokens;       // Tokens of the region being reparsed
+    UnitList units;           // Top-level statements in source order
+    NameInfo *names;          // Indexed by intern ID
+    unsigned int name_capacity;
+    int seen_stamp;
+    int diff_stamp;
+    unsigned int *changed;    // Names compared by the current diff
+    int changed_count;
+    int changed_capacity;
+    UnitList queue;           // Units to recheck: a min-heap on index
+    int syntax_errors;        // Sum of syntax_count over the units
+    Arena tree_arena;         // Program node of document_tree
+    DocumentEditStats stats;
+};
+
+// -----------------------------------------------------------------
+// Small containers
+// -----------------------------------------------------------------
+
+static int unit_list_push(UnitList *list, Unit *unit) {
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 8;
+        Unit **items = realloc(list->items, (size_t)capacity * sizeof(Unit *));
+        if (!items) {
+            return 0;
+        }
+        list->items = items;
+        list->capacity = capacity;
+    }
+    list->items[list->count++] = unit;
+    return 1;
+}
+
+// Remove `unit` from an unordered list.
+static void unit_list_remove(UnitList *list, const Unit *unit) {
+    for (int i = 0; i < list->count; i++) {
+        if (list->items[i] == unit) {
+            list->items[i] = list->items[--list->count];
+            return;
+        }
+    }
+}
+
+static void queue_push(Document *doc, Unit *unit) {
+    if (unit->queued || !unit_list_push(&doc->queue, unit)) {
+        return;
+    }
+    unit->queued = 1;
+    Unit **heap = doc->queue.items;
+    for (int i = doc->queue.count - 1; i > 0 && heap[(i - 1) / 2]->index > heap[i]->index; i = (i - 1) / 2) {
+        Unit *parent = heap[(i - 1) / 2];
+        heap[(i - 1) / 2] = heap[i];
+        heap[i] = parent;
+    }
+}
+
+static Unit *queue_pop(Document *doc) {
+    Unit **heap = doc->queue.items;
+    Unit *top = heap[0];
+    heap[0] = heap[--doc->queue.count];
+    int i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= doc->queue.count) {
+            break;
+        }
+        if (child + 1 < doc->queue.count && heap[child + 1]->index < heap[child]->index) {
+            child++;
+        }
+        if (heap[i]->index <= heap[child]->index) {
+            break;
+        }
+        Unit *swap = heap[i];
+        heap[i] = heap[child];
+        heap[child] = swap;
+        i = child;
+    }
+    top->queued = 0;
+    return top;
+}
+
+// Make doc->names cover every intern ID handed out so far.
+static int ensure_names(Document *doc) {
+    if (doc->strings.count <= doc->name_capacity) {
+        return 1;
+    }
+    unsigned int capacity = doc->name_capacity ? doc->name_capacity : 256;
+    while (capacity < doc->strings.count) {
+        capacity *= 2;
+    }
+    NameInfo *names = realloc(doc->names, capacity * sizeof(NameInfo));
+    if (!names) {
+        return 0;
+    }
+    memset(names + doc->name_capacity, 0, (capacity - doc->name_capacity) * sizeof(NameInfo));
+    doc->names = names;
+    doc->name_capacity = capacity;
+    return 1;
+}
+
+// -----------------------------------------------------------------
+// Units
+// -----------------------------------------------------------------
+
+typedef struct {
+    Document *doc;
+    Unit *unit;
+} NameCollector;
+
+static AstWalkAction collect_name(const AstVisit *visit, void *context) {
+    NameCollector *collector = context;
+    Document *doc = collector->doc;
+    Unit *unit = collector->unit;
+    const ASTNode *node = visit->node;
+    if (node->type == AST_IDENTIFIER || node->type == AST_VARDECL) {
+        NameInfo *info = &doc->names[node->token.id];
+        if (info->seen != doc->seen_stamp) {
+            info->seen = doc->seen_stamp;
+            unsigned int *names = realloc(unit->names, (size_t)(unit->name_count + 1) * sizeof(unsigned int));
+            if (names) {
+                unit->names = names;
+                unit->names[unit->name_count++] = node->token.id;
+            }
+        }
+    }
+    return AST_WALK_CONTINUE;
+}
+
+// Record the names of a freshly parsed unit and index it as their reader.
+static void register_names(Document *doc, Unit *unit) {
+    doc->seen_stamp++;
+    NameCollector collector = {doc, unit};
+    AstVisitor visitor = {collect_name, NULL, &collector};
+    ast_walk(unit->statement, &visitor, 1);
+    for (int i = 0; i < unit->name_count; i++) {
+        unit_list_push(&doc->names[unit->names[i]].readers, unit);
+    }
+}
+
+static void drop_effects(Document *doc, Unit *unit) {
+    for (int i = 0; i < unit->effect_count; i++) {
+        unit_list_remove(&doc->names[unit->effects[i].name].writers, unit);
+    }
+    free(unit->effects);
+    unit->effects = NULL;
+    unit->effect_count = 0;
+}
+
+static void free_unit(Document *doc, Unit *unit) {
+    for (int i = 0; i < unit->name_count; i++) {
+        unit_list_remove(&doc->names[unit->names[i]].readers, unit);
+    }
+    drop_effects(doc, unit);
+    doc->syntax_errors -= unit->syntax_count;
+    free(unit->syntax);
+    free(unit->semantic);
+    free(unit->names);
+    if (--unit->generation->refs == 0) {
+        arena_destroy(&unit->generation->arena);
+        free(unit->generation);
+    }
+    free(unit);
+}
+
+// Effects on `name` of the statements before position `index`.
+static int effects_before(const Document *doc, unsigned int name, int index) {
+    const UnitList *writers = &doc->names[name].writers;
+    int kinds = 0;
+    for (int i = 0; i < writers->count; i++) {
+        const Unit *writer = writers->items[i];
+        if (writer->index >= index) {
+            continue;
+        }
+        for (int k = 0; k < writer->effect_count; k++) {
+            if (writer->effects[k].name == name) {
+                kinds |= writer->effects[k].kinds;
+            }
+        }
+    }
+    return kinds;
+}
+
+// Check one top-level statement against the globals the statements before
+// it leave behind, exactly as check_program would reach it, and record
+// its diagnostics and effects. Only the names the statement mentions are
+// loaded, since no other symbol can influence it.
+static void check_unit(Document *doc, Unit *unit) {
+    drop_effects(doc, unit);
+    free(unit->semantic);
+    unit->semantic = NULL;
+    unit->semantic_count = 0;
+    if (!unit->statement) {
+        return;
+    }
+    SymbolTable *table = init_symbol_table();
+    int *before = malloc((size_t)(unit->name_count + 1) * sizeof(int));
+    if (!table || !before) {
+        if (table) free_symbol_table(table);
+        free(before);
+        return;
+    }
+    for (int i = 0; i < unit->name_count; i++) {
+        before[i] = effects_before(doc, unit->names[i], unit->index);
+        if (before[i] & EFFECT_DECLARE) {
+            Symbol *symbol = add_symbol(table, intern_string(&doc->strings, unit->names[i]), TOKEN_INT, 0);
+            if (symbol) {
+                symbol->is_initialized = (before[i] & EFFECT_INITIALIZE) != 0;
+            }
+        }
+    }
+    check_statement(unit->statement, table);
+    unit->semantic = table->diagnostics.items;  // Take the records over
+    unit->semantic_count = table->diagnostics.count;
+    memset(&table->diagnostics, 0, sizeof(table->diagnostics));
+
+    for (int i = 0; i < unit->name_count; i++) {
+        Symbol *symbol = lookup_symbol(table, intern_string(&doc->strings, unit->names[i]));
+        int kinds = 0;
+        if (symbol && !(before[i] & EFFECT_DECLARE)) {
+            kinds |= EFFECT_DECLARE;
+        }
+        if (symbol && symbol->is_initialized && !(before[i] & EFFECT_INITIALIZE)) {
+            kinds |= EFFECT_INITIALIZE;
+        }
+        if (!kinds) {
+            continue;
+        }
+        Effect *effects = realloc(unit->effects, (size_t)(unit->effect_count + 1) * sizeof(Effect));
+        if (!effects || !unit_list_push(&doc->names[unit->names[i]].writers, unit)) {
+            if (effects) unit->effects = effects;
+            continue;
+        }
+        unit->effects = effects;
+        unit->effects[unit->effect_count].name = unit->names[i];
+        unit->effects[unit->effect_count].kinds = kinds;
+        unit->effect_count++;
+    }
+    free(before);
+    free_symbol_table(table);
+}
+
+// -----------------------------------------------------------------
+// Comparing effects: which globals look different to later statements
+// -----------------------------------------------------------------
+
+static void diff_begin(Document *doc) {
+    doc->diff_stamp++;
+    doc->changed_count = 0;
+}
+
+// Add the effects of `unit` to the old (side 0) or new (side 1) picture.
+static void diff_add(Document *doc, const Unit *unit, int side) {
+    for (int i = 0; i < unit->effect_count; i++) {
+        NameInfo *info = &doc->names[unit->effects[i].name];
+        if (info->stamp != doc->diff_stamp) {
+            if (doc->changed_count == doc->changed_capacity) {
+                int capacity = doc->changed_capacity ? doc->changed_capacity * 2 : 16;
+                unsigned int *changed = realloc(doc->changed, (size_t)capacity * sizeof(unsigned int));
+                if (!changed) {
+                    continue;
+                }
+                doc->changed = changed;
+                doc->changed_capacity = capacity;
+            }
+            info->stamp = doc->diff_stamp;
+            info->kinds[0] = info->kinds[1] = 0;
+            doc->changed[doc->changed_count++] = unit->effects[i].name;
+        }
+        info->kinds[side] |= unit->effects[i].kinds;
+    }
+}
+
+// Queue every statement after position `after` that mentions a name whose
+// effects differ between the two pictures.
+static void diff_queue(Document *doc, int after) {
+    for (int i = 0; i < doc->changed_count; i++) {
+        NameInfo *info = &doc->names[doc->changed[i]];
+        if (info->kinds[0] == info->kinds[1]) {
+            continue;
+        }
+        for (int r = 0; r < info->readers.count; r++) {
+            if (info->readers.items[r]->index > after) {
+                queue_push(doc, info->readers.items[r]);
+            }
+        }
+    }
+}
+
+// -----------------------------------------------------------------
+// Line relocation for statements below an edit that added or removed lines
+// -----------------------------------------------------------------
+
+static void shift_lines(ASTNode *node, int shift) {
+    if (!node) return;
+    node->token.line += shift;
+    for (int i = 0; i < node->child_count; i++) {
+        shift_lines(node->children[i], shift);
+    }
+    shift_lines(node->left, shift);
+    shift_lines(node->right, shift);
+    shift_lines(node->else_branch, shift);
+}
+
+// Bring the tree and diagnostics of `unit` up to its current lines. Its
+// columns never move: an edit only stops growing the reparsed region at a
+// line break (see ends_line).
+static void settle_lines(Unit *unit) {
+    if (!unit->line_shift) {
+        return;
+    }
+    shift_lines(unit->statement, unit->line_shift);
+    for (int i = 0; i < unit->syntax_count; i++) {
+        unit->syntax[i].line += unit->line_shift;
+    }
+    for (int i = 0; i < unit->semantic_count; i++) {
+        unit->semantic[i].line += unit->line_shift;
+    }
+    unit->line_shift = 0;
+}
+
+// -----------------------------------------------------------------
+// Reparsing
+// -----------------------------------------------------------------
+
+// Lex text [start, end), which begins on `line`, and parse it as top-level
+// statements appended to `out`. The region lexes exactly as it would in
+// the whole text as long as `start` is a statement boundary; whether its
+// end is one is for the caller to judge. Returns 0 if memory ran out.
+static int parse_region(Document *doc, size_t start, size_t end, int line, UnitList *out) {
+    char saved = doc->text[end];
+    doc->text[end] = '\0';
+    Lexer lexer;
+    lexer_init(&lexer, doc->text + start, &doc->strings);
+    lexer.line = line;
+    size_t line_begin = start;
+    while (line_begin > 0 && doc->text[line_begin - 1] != '\n') {
+        line_begin--;
+    }
+    lexer.line_start = -(int)(start - line_begin);  // Columns count from the real line start
+    int lexed = lexer_tokenize(&lexer, &doc->tokens);
+    doc->text[end] = saved;
+    Generation *generation = calloc(1, sizeof(Generation));
+    if (!lexed || !generation || !ensure_names(doc)) {
+        free(generation);
+        return 0;
+    }
+    doc->stats.relexed_bytes += end - start;
+
+    Parser parser;
+    memset(&parser, 0, sizeof(parser));
+    parser_context_init_tokens(&parser, &doc->tokens);
+    ASTNode *statement;
+    int ok = 1;
+    while (ok && parser_context_parse_next(&parser, &statement)) {
+        int last = parser.token_index - 1;  // Every statement consumes at least one token
+        Unit *unit = calloc(1, sizeof(Unit));
+        if (!unit || !unit_list_push(out, unit)) {
+            free(unit);
+            ok = 0;
+            break;
+        }
+        unit->end = start + (size_t)doc->tokens.offsets[last] +
+                    doc->strings.entries[doc->tokens.ids[last]].length;
+        unit->line = doc->tokens.lines[last];
+        unit->statement = statement;
+        unit->generation = generation;
+        generation->refs++;
+        unit->syntax_count = parser.diagnostics.count;
+        unit->clean = parser.diagnostics.count == 0;
+        if (parser.diagnostics.count) {
+            unit->syntax = parser.diagnostics.items;  // Take the records over
+            memset(&parser.diagnostics, 0, sizeof(parser.diagnostics));
+            doc->syntax_errors += unit->syntax_count;
+        }
+        doc->stats.reparsed++;
+    }
+    generation->arena = parser.arena;
+    memset(&parser.arena, 0, sizeof(parser.arena));
+    parser_context_destroy(&parser);
+    if (generation->refs == 0) {
+        arena_destroy(&generation->arena);
+        free(generation);
+    }
+    return ok;
+}
+
+// Number of units ending before `offset` (or at it, if `inclusive`).
+static int units_ending_before(const Document *doc, size_t offset, int inclusive) {
+    int low = 0, high = doc->units.count;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        size_t end = doc->units.items[mid]->end;
+        if (end < offset || (inclusive && end == offset)) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+// 1 if a line break comes before any token after `offset`: the tokens
+// from there on keep their columns whatever the edit did before it.
+static int ends_line(const Document *doc, size_t offset) {
+    for (const char *p = doc->text + offset; *p; p++) {
+        if (*p == '\n') {
+            return 1;
+        }
+        if (*p != ' ' && *p != '\t' && *p != '\r') {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int count_lines(const char *text, size_t length) {
+    int lines = 0;
+    for (size_t i = 0; i < length; i++) {
+        lines += text[i] == '\n';
+    }
+    return lines;
+}
+
+int document_edit(Document *doc, size_t start, size_t end, const char *text, size_t length) {
+    if (start > end || end > doc->length) {
+        return 0;
+    }
+    memset(&doc->stats, 0, sizeof(doc->stats));
+    UnitList *units = &doc->units;
+    int n = units->count;
+
+    // Units the edit touches; touching a boundary counts, since the new
+    // text may join the tokens on either side of it. The unit before them
+    // is reparsed too: its parse may have peeked at their first token.
+    int first = units_ending_before(doc, start, 0);
+    int next = units_ending_before(doc, end, 1) + 1;  // First unit left alone
+    if (next > n) next = n;
+    if (first > 0) first--;
+    size_t region_start = first > 0 ? units->items[first - 1]->end : 0;
+    int region_line = first > 0 ? units->items[first - 1]->line : 1;
+
+    // Apply the edit to the text.
+    size_t new_length = doc->length - (end - start) + length;
+    if (new_length + 1 > doc->capacity) {
+        size_t capacity = doc->capacity * 2 > new_length + 1 ? doc->capacity * 2 : new_length + 1;
+        char *grown = realloc(doc->text, capacity);
+        if (!grown) {
+            return 0;
+        }
+        doc->text = grown;
+        doc->capacity = capacity;
+    }
+    int line_delta = count_lines(text, length) - count_lines(doc->text + start, end - start);
+    memmove(doc->text + start + length, doc->text + end, doc->length - end + 1);
+    memcpy(doc->text + start, text, length);
+    doc->length = new_length;
+    size_t delta = length - (end - start);  // Wraps when text shrinks; offsets wrap back
+
+    // Reparse until the region ends on a clean statement that ends exactly
+    // where an old one did, at the end of a line (the old tokens and trees
+    // after it still hold), or at the end of the text. Clean statements already parsed are kept
+    // when the region has to grow; it grows by twice as many old units
+    // each time, so an unclosed '{' costs one pass over the rest, not one
+    // pass per statement.
+    UnitList fresh = {0};
+    int grow = 1;
+    for (;;) {
+        size_t region_end = next == n ? doc->length : units->items[next - 1]->end + delta;
+        int kept = fresh.count;
+        if (!parse_region(doc, region_start, region_end, region_line, &fresh)) {
+            for (int i = 0; i < fresh.count; i++) free_unit(doc, fresh.items[i]);
+            free(fresh.items);
+            return 0;
+        }
+        if (next == n) {
+            break;
+        }
+        if (fresh.count > kept && fresh.items[fresh.count - 1]->clean &&
+            fresh.items[fresh.count - 1]->end == region_end && ends_line(doc, region_end)) {
+            break;
+        }
+        int keep = fresh.count;
+        while (keep > kept && !fresh.items[keep - 1]->clean) {
+            keep--;
+        }
+        for (int i = keep; i < fresh.count; i++) {
+            free_unit(doc, fresh.items[i]);
+        }
+        fresh.count = keep;
+        if (keep > 0) {
+            region_start = fresh.items[keep - 1]->end;
+            region_line = fresh.items[keep - 1]->line;
+        }
+        next = next + grow < n ? next + grow : n;
+        grow *= 2;
+    }
+
+    // Replace the old units [first, next) and move the ones after them.
+    diff_begin(doc);
+    for (int i = first; i < next; i++) {
+        diff_add(doc, units->items[i], 0);
+        free_unit(doc, units->items[i]);
+    }
+    int old_count = next - first;
+    int total = n - old_count + fresh.count;
+    if (total > units->capacity) {
+        Unit **items = realloc(units->items, (size_t)total * sizeof(Unit *));
+        if (!items) {
+            free(fresh.items);
+            return 0;
+        }
+        units->items = items;
+        units->capacity = total;
+    }
+    if (n > next) {
+        memmove(units->items + first + fresh.count, units->items + next, (size_t)(n - next) * sizeof(Unit *));
+    }
+    if (fresh.count) {
+        memcpy(units->items + first, fresh.items, (size_t)fresh.count * sizeof(Unit *));
+    }
+    units->count = total;
+    free(fresh.items);
+    for (int i = first; i < total; i++) {
+        Unit *unit = units->items[i];
+        unit->index = i;
+        if (i >= first + fresh.count) {
+            unit->end += delta;
+            unit->line += line_delta;
+            unit->line_shift += line_delta;
+        }
+    }
+
+    // Check the new statements in order, then every later statement that
+    // sees a global differently, until the differences stop spreading.
+    for (int i = first; i < first + fresh.count; i++) {
+        register_names(doc, units->items[i]);
+        check_unit(doc, units->items[i]);
+        doc->stats.rechecked++;
+        diff_add(doc, units->items[i], 1);
+    }
+    diff_queue(doc, first + fresh.count - 1);
+    while (doc->queue.count > 0) {
+        Unit *unit = queue_pop(doc);
+        settle_lines(unit);
+        diff_begin(doc);
+        diff_add(doc, unit, 0);
+        check_unit(doc, unit);
+        doc->stats.rechecked++;
+        diff_add(doc, unit, 1);
+        diff_queue(doc, unit->index);
+    }
+    return 1;
+}
+
+// -----------------------------------------------------------------
+// Document interface
+// -----------------------------------------------------------------
+
+Document *document_open(const char *text) {
+    Document *doc = calloc(1, sizeof(Document));
+    if (!doc) {
+        return NULL;
+    }
+    doc->capacity = 64;
+    doc->text = calloc(doc->capacity, 1);
+    if (!lexer_init_strings(&doc->strings) || !doc->text || !document_edit(doc, 0, 0, text, strlen(text))) {
+        document_close(doc);
+        return NULL;
+    }
+    return doc;
+}
+
+void document_close(Document *doc) {
+    if (!doc) return;
+    for (int i = 0; i < doc->units.count; i++) {
+        free_unit(doc, doc->units.items[i]);
+    }
+    free(doc->units.items);
+    for (unsigned int i = 0; i < doc->name_capacity; i++) {
+        free(doc->names[i].readers.items);
+        free(doc->names[i].writers.items);
+    }
+    free(doc->names);
+    free(doc->changed);
+    free(doc->queue.items);
+    free_token_buffer(&doc->tokens);
+    intern_free(&doc->strings);
+    arena_destroy(&doc->tree_arena);
+    free(doc->text);
+    free(doc);
+}
+
+const char *document_text(const Document *doc) {
+    return doc->text;
+}
+
+size_t document_length(const Document *doc) {
+    return doc->length;
+}
+
+DocumentEditStats document_last_edit(const Document *doc) {
+    return doc->stats;
+}
+
+// Diagnostics of statements that moved are brought up to date on the way.
+int document_diagnostics(Document *doc, DiagnosticList *out) {
+    for (int i = 0; i < doc->units.count; i++) {
+        Unit *unit = doc->units.items[i];
+        settle_lines(unit);
+        if (doc->syntax_errors) {
+            diagnostics_append(out, unit->syntax, unit->syntax_count);
+        } else {
+            diagnostics_append(out, unit->semantic, unit->semantic_count);
+        }
+    }
+    return doc->syntax_errors;
+}
+
+int document_print_diagnostics(Document *doc, FILE *out) {
+    for (int i = 0; i < doc->units.count; i++) {
+        Unit *unit = doc->units.items[i];
+        settle_lines(unit);
+        if (doc->syntax_errors) {
+            diagnostics_print(unit->syntax, unit->syntax_count, DIAGNOSTICS_TEXT, NULL, out);
+        } else {
+            diagnostics_print(unit->semantic, unit->semantic_count, DIAGNOSTICS_TEXT, NULL, out);
+        }
+    }
+    return doc->syntax_errors;
+}
+
+ASTNode *document_tree(Document *doc) {
+    arena_reset(&doc->tree_arena);
+    ASTNode *program = arena_alloc(&doc->tree_arena, sizeof(ASTNode));
+    ASTNode **children = arena_alloc(&doc->tree_arena, (size_t)(doc->units.count + 1) * sizeof(ASTNode *));
+    if (!program || !children) {
+        return NULL;
+    }
+    memset(program, 0, sizeof(ASTNode));
+    program->type = AST_PROGRAM;
+    program->token.type = TOKEN_EOF;
+    program->token.lexeme = intern_string(&doc->strings, LEXEME_EMPTY);
+    program->token.id = LEXEME_EMPTY;
+    program->token.line = 1;
+    program->slot = -1;
+    program->depth = -1;
+    for (int i = 0; i < doc->units.count; i++) {
+        Unit *unit = doc->units.items[i];
+        settle_lines(unit);
+        if (unit->statement) {
+            children[program->child_count++] = unit->statement;
+        }
+    }
+    program->children = program->child_count ? children : NULL;
+    return program;
+}
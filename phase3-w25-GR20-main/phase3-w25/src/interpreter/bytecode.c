@@ -0,0 +1,280 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "../../include/bytecode.h"
+#include "../../include/stats.h"
+
+// -----------------------------------------------------------------
+// AST -> bytecode lowering. Expressions are emitted in postfix order
+// for the operand stack; control flow becomes relative jumps. While
+// loops are emitted with the test at the bottom so each iteration
+// executes a single conditional jump.
+// -----------------------------------------------------------------
+
+typedef struct {
+    Chunk *chunk;
+    int depth;                // Operand stack depth at the current point
+    int ok;                   // Cleared on the first failure
+} Compiler;
+
+static void compile_statement(Compiler *c, ASTNode *node);
+
+// Append one instruction word (and its source line).
+static int emit(Compiler *c, OpCode op, int arg, int line) {
+    Chunk *chunk = c->chunk;
+    if (!c->ok) {
+        return -1;
+    }
+    if (arg < BYTECODE_ARG_MIN || arg > BYTECODE_ARG_MAX) {
+        c->ok = 0;
+        return -1;
+    }
+    if (chunk->count == chunk->capacity) {
+        int capacity = chunk->capacity ? chunk->capacity * 2 : 256;
+        uint32_t *code = realloc(chunk->code, capacity * sizeof(uint32_t));
+        if (code) {
+            chunk->code = code;
+        }
+        int *lines = realloc(chunk->lines, capacity * sizeof(int));
+        if (lines) {
+            chunk->lines = lines;
+        }
+        if (!code || !lines) {
+            c->ok = 0;
+            return -1;
+        }
+        chunk->capacity = capacity;
+    }
+    chunk->code[chunk->count] = (uint32_t)op | ((uint32_t)arg << 8);
+    chunk->lines[chunk->count] = line;
+    return chunk->count++;
+}
+
+// Track operand stack depth so the VM can size its stack up front.
+static void adjust_depth(Compiler *c, int delta) {
+    c->depth += delta;
+    if (c->depth > c->chunk->max_stack) {
+        c->chunk->max_stack = c->depth;
+    }
+}
+
+// Point the jump at `at` to the instruction that will be emitted next.
+static void patch_jump(Compiler *c, int at) {
+    if (at < 0) {
+        return;
+    }
+    int offset = c->chunk->count - (at + 1);
+    if (offset > BYTECODE_ARG_MAX) {
+        c->ok = 0;
+        return;
+    }
+    c->chunk->code[at] = (c->chunk->code[at] & 0xFF) | ((uint32_t)offset << 8);
+}
+
+// Emit a jump back (or forward) to `target`.
+static void emit_jump_to(Compiler *c, OpCode op, int target, int line) {
+    emit(c, op, target - (c->chunk->count + 1), line);
+}
+
+static int add_constant(Compiler *c, Value value) {
+    Chunk *chunk = c->chunk;
+    if (chunk->constant_count == chunk->constant_capacity) {
+        int capacity = chunk->constant_capacity ? chunk->constant_capacity * 2 : 64;
+        Value *constants = realloc(chunk->constants, capacity * sizeof(Value));
+        if (!constants) {
+            c->ok = 0;
+            return 0;
+        }
+        chunk->constants = constants;
+        chunk->constant_capacity = capacity;
+    }
+    chunk->constants[chunk->constant_count] = value;
+    return chunk->constant_count++;
+}
+
+static int binary_opcode(unsigned int id) {
+    switch (id) {
+        case LEXEME_PLUS:  return OP_ADD;
+        case LEXEME_MINUS: return OP_SUB;
+        case LEXEME_STAR:  return OP_MUL;
+        case LEXEME_SLASH: return OP_DIV;
+        case LEXEME_LT:    return OP_LT;
+        case LEXEME_GT:    return OP_GT;
+        case LEXEME_LE:    return OP_LE;
+        case LEXEME_GE:    return OP_GE;
+        case LEXEME_EQ:    return OP_EQ;
+        case LEXEME_NE:    return OP_NE;
+        default:           return -1;
+    }
+}
+
+// Emit code leaving the value of an expression on the stack.
+static void compile_expression(Compiler *c, ASTNode *node) {
+    int line = node->token.line;
+    switch (node->type) {
+        case AST_NUMBER:
+            emit(c, OP_CONST, add_constant(c, node->token.value), line);
+            adjust_depth(c, 1);
+            break;
+        case AST_IDENTIFIER:
+            if (node->slot < 0) {
+                c->ok = 0;  // Not resolved by semantic analysis
+            }
+            emit(c, OP_LOAD, node->slot, line);
+            adjust_depth(c, 1);
+            break;
+        case AST_FUNCALL:
+            compile_expression(c, node->left);
+            emit(c, OP_FACTORIAL, 0, line);
+            break;
+        case AST_BINOP: {
+            int op = binary_opcode(node->token.id);
+            compile_expression(c, node->left);
+            compile_expression(c, node->right);
+            if (op < 0) {
+                c->ok = 0;
+            }
+            emit(c, (OpCode)op, 0, line);
+            adjust_depth(c, -1);
+            break;
+        }
+        default:
+            c->ok = 0;
+            break;
+    }
+}
+
+// Emit every statement of an AST_PROGRAM or AST_BLOCK.
+static void compile_children(Compiler *c, ASTNode *node) {
+    for (int i = 0; i < node->child_count && c->ok; i++) {
+        compile_statement(c, node->children[i]);
+    }
+}
+
+static void compile_statement(Compiler *c, ASTNode *node) {
+    int line = node->token.line;
+    switch (node->type) {
+        case AST_PROGRAM:
+        case AST_BLOCK:
+            compile_children(c, node);
+            break;
+        case AST_VARDECL:
+            if (node->slot < 0) {
+                c->ok = 0;
+            }
+            emit(c, OP_CLEAR, node->slot, line);
+            break;
+        case AST_ASSIGN:
+            compile_expression(c, node->right);
+            if (node->left->slot < 0) {
+                c->ok = 0;
+            }
+            emit(c, OP_STORE, node->left->slot, line);
+            adjust_depth(c, -1);
+            break;
+        case AST_PRINT:
+            compile_expression(c, node->left);
+            emit(c, OP_PRINT, 0, line);
+            adjust_depth(c, -1);
+            break;
+        case AST_IF: {
+            compile_expression(c, node->left);
+            int to_else = emit(c, OP_JUMP_IF_FALSE, 0, line);
+            adjust_depth(c, -1);
+            compile_statement(c, node->right);
+            if (node->else_branch) {
+                int to_end = emit(c, OP_JUMP, 0, line);
+                patch_jump(c, to_else);
+                compile_statement(c, node->else_branch);
+                patch_jump(c, to_end);
+            } else {
+                patch_jump(c, to_else);
+            }
+            break;
+        }
+        case AST_WHILE: {
+            // jump test; body: ...; test: cond; jump-if-true body
+            int to_test = emit(c, OP_JUMP, 0, line);
+            int body = c->chunk->count;
+            compile_statement(c, node->right);
+            patch_jump(c, to_test);
+            compile_expression(c, node->left);
+            emit_jump_to(c, OP_JUMP_IF_TRUE, body, line);
+            adjust_depth(c, -1);
+            break;
+        }
+        case AST_REPEAT: {
+            int body = c->chunk->count;
+            compile_statement(c, node->left);
+            compile_expression(c, node->right);
+            emit_jump_to(c, OP_JUMP_IF_FALSE, body, line);
+            adjust_depth(c, -1);
+            break;
+        }
+        default:
+            compile_expression(c, node);  // Expression used as a statement
+            emit(c, OP_POP, 0, line);
+            adjust_depth(c, -1);
+            break;
+    }
+}
+
+int bytecode_compile(ASTNode *program, int slot_count, Chunk *chunk) {
+    Chunk empty = {0};
+    *chunk = empty;
+    chunk->slot_count = slot_count;
+    Compiler c = {chunk, 0, 1};
+    STATS_START(timer);
+    if (program) {
+        compile_statement(&c, program);
+    }
+    emit(&c, OP_HALT, 0, 0);
+    STATS_STOP(STATS_BYTECODE, timer);
+    if (!c.ok) {
+        chunk_free(chunk);
+        return 0;
+    }
+    return 1;
+}
+
+void chunk_free(Chunk *chunk) {
+    free(chunk->code);
+    free(chunk->lines);
+    free(chunk->constants);
+    Chunk empty = {0};
+    *chunk = empty;
+}
+
+static const char *opcode_names[OP_COUNT] = {
+    "CONST", "LOAD", "STORE", "CLEAR", "ADD", "SUB", "MUL", "DIV",
+    "LT", "GT", "LE", "GE", "EQ", "NE", "FACTORIAL", "PRINT", "POP",
+    "JUMP", "JUMP_IF_FALSE", "JUMP_IF_TRUE", "HALT"
+};
+
+// Print one instruction per line: index, source line, opcode, operand.
+void chunk_disassemble(const Chunk *chunk, FILE *out) {
+    fprintf(out, "== BYTECODE: %d instructions, %d constants, %d slots, stack %d ==\n",
+            chunk->count, chunk->constant_count, chunk->slot_count, chunk->max_stack);
+    for (int i = 0; i < chunk->count; i++) {
+        OpCode op = BYTECODE_OP(chunk->code[i]);
+        int arg = BYTECODE_ARG(chunk->code[i]);
+        fprintf(out, "%5d  line %-4d %-14s", i, chunk->lines[i], op < OP_COUNT ? opcode_names[op] : "?");
+        switch (op) {
+            case OP_CONST:
+                fprintf(out, " %d (%lld)", arg, chunk->constants[arg]);
+                break;
+            case OP_LOAD:
+            case OP_STORE:
+            case OP_CLEAR:
+                fprintf(out, " slot %d", arg);
+                break;
+            case OP_JUMP:
+            case OP_JUMP_IF_FALSE:
+            case OP_JUMP_IF_TRUE:
+                fprintf(out, " -> %d", i + 1 + arg);
+                break;
+            default:
+                break;
+        }
+        fprintf(out, "\n");
+    }
+}
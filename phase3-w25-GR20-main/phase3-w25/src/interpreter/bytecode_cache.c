@@ -0,0 +1,289 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/bytecode_cache.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CACHE_HAVE_MKSTEMP 1
+#include <unistd.h>
+#endif
+
+// -----------------------------------------------------------------
+// Entry layout (native byte order, every section naturally aligned):
+//   EntryHeader
+//   Value    constants[constant_count]
+//   uint32_t code[code_count]
+//   int32_t  lines[code_count]
+//   char     diagnostics[diagnostics_length + 1]
+// -----------------------------------------------------------------
+
+#define CACHE_MAGIC "MINIBC\r\n"
+#define CACHE_BYTE_ORDER 0x01020304u
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;      // CACHE_BYTE_ORDER as written by this machine
+    uint64_t source_hash;
+    uint64_t source_size;
+    uint32_t value_size;      // sizeof(Value)
+    uint32_t code_count;
+    uint32_t constant_count;
+    uint32_t slot_count;
+    uint32_t max_stack;
+    uint32_t tokens;
+    uint32_t diagnostics_length;
+    uint32_t reserved;
+} EntryHeader;
+
+unsigned long long bytecode_cache_hash(const char* text, size_t size) {
+    unsigned long long hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= (unsigned char)text[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static void entry_path(char* path, size_t length, const char* dir, unsigned long long hash) {
+    snprintf(path, length, "%s/%016llx.mbc", dir, hash);
+}
+
+// Bytes the entry described by `header` must occupy.
+static size_t entry_size(const EntryHeader* header) {
+    return sizeof(EntryHeader) +
+           (size_t)header->constant_count * sizeof(Value) +
+           (size_t)header->code_count * (sizeof(uint32_t) + sizeof(int32_t)) +
+           (size_t)header->diagnostics_length + 1;
+}
+
+// Operands an instruction pops and the net change it makes to the stack.
+static void stack_effect(OpCode op, int* pops, int* delta) {
+    switch (op) {
+        case OP_CONST:
+        case OP_LOAD:
+            *pops = 0;
+            *delta = 1;
+            break;
+        case OP_STORE:
+        case OP_PRINT:
+        case OP_POP:
+        case OP_JUMP_IF_FALSE:
+        case OP_JUMP_IF_TRUE:
+            *pops = 1;
+            *delta = -1;
+            break;
+        case OP_FACTORIAL:
+            *pops = 1;
+            *delta = 0;
+            break;
+        case OP_ADD:
+        case OP_SUB:
+        case OP_MUL:
+        case OP_DIV:
+        case OP_LT:
+        case OP_GT:
+        case OP_LE:
+        case OP_GE:
+        case OP_EQ:
+        case OP_NE:
+            *pops = 2;
+            *delta = -1;
+            break;
+        default:
+            *pops = 0;
+            *delta = 0;
+            break;
+    }
+}
+
+// Follow every path from the first instruction, as bytecode.c does when it
+// computes max_stack: no instruction may pop more than the stack holds or
+// push it beyond max_stack, and every path into an instruction must arrive
+// with the same depth. Run after the operands have been checked.
+static int verify_stack(const Chunk* chunk) {
+    int* depth = malloc((size_t)chunk->count * sizeof(int));
+    int* pending = malloc((size_t)chunk->count * sizeof(int));
+    if (!depth || !pending) {
+        free(depth);
+        free(pending);
+        return 0;
+    }
+    for (int i = 0; i < chunk->count; i++) {
+        depth[i] = -1;  // Not reached yet
+    }
+    int pending_count = 0;
+    depth[0] = 0;
+    pending[pending_count++] = 0;
+    int ok = 1;
+    while (ok && pending_count > 0) {
+        int pc = pending[--pending_count];
+        OpCode op = BYTECODE_OP(chunk->code[pc]);
+        int pops;
+        int delta;
+        stack_effect(op, &pops, &delta);
+        int after = depth[pc] + delta;
+        if (depth[pc] < pops || after > chunk->max_stack) {
+            ok = 0;
+            break;
+        }
+        int successors[2];
+        int successor_count = 0;
+        if (op != OP_JUMP && op != OP_HALT) {
+            successors[successor_count++] = pc + 1;
+        }
+        if (op == OP_JUMP || op == OP_JUMP_IF_FALSE || op == OP_JUMP_IF_TRUE) {
+            successors[successor_count++] = pc + 1 + BYTECODE_ARG(chunk->code[pc]);
+        }
+        for (int s = 0; s < successor_count; s++) {
+            int next = successors[s];
+            if (next >= chunk->count) {
+                ok = 0;
+            } else if (depth[next] < 0) {
+                depth[next] = after;
+                pending[pending_count++] = next;
+            } else if (depth[next] != after) {
+                ok = 0;
+            }
+        }
+    }
+    free(depth);
+    free(pending);
+    return ok;
+}
+
+// Reject code whose operands would index outside the entry, or whose stack
+// use does not match the header (a truncated or corrupted file must not
+// crash the VM).
+static int verify_code(const Chunk* chunk) {
+    if (chunk->count == 0 || BYTECODE_OP(chunk->code[chunk->count - 1]) != OP_HALT) {
+        return 0;
+    }
+    for (int i = 0; i < chunk->count; i++) {
+        OpCode op = BYTECODE_OP(chunk->code[i]);
+        int arg = BYTECODE_ARG(chunk->code[i]);
+        switch (op) {
+            case OP_CONST:
+                if (arg < 0 || arg >= chunk->constant_count) return 0;
+                break;
+            case OP_LOAD:
+            case OP_STORE:
+            case OP_CLEAR:
+                if (arg < 0 || arg >= chunk->slot_count) return 0;
+                break;
+            case OP_JUMP:
+            case OP_JUMP_IF_FALSE:
+            case OP_JUMP_IF_TRUE:
+                if (i + 1 + arg < 0 || i + 1 + arg >= chunk->count) return 0;
+                break;
+            default:
+                if (op >= OP_COUNT) return 0;
+                break;
+        }
+    }
+    return chunk->max_stack >= 0 && verify_stack(chunk);
+}
+
+int bytecode_cache_load(const char* dir, const char* source, size_t size, CachedProgram* program) {
+    unsigned long long hash = bytecode_cache_hash(source, size);
+    char path[4096];
+    entry_path(path, sizeof(path), dir, hash);
+    memset(program, 0, sizeof(*program));
+    if (!source_open_binary(&program->file, path)) {
+        return 0;
+    }
+
+    const char* data = program->file.data;
+    const EntryHeader* header = (const EntryHeader*)data;
+    if (program->file.size < sizeof(EntryHeader) ||
+        memcmp(header->magic, CACHE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != BYTECODE_CACHE_VERSION ||
+        header->byte_order != CACHE_BYTE_ORDER ||
+        header->value_size != sizeof(Value) ||
+        header->source_hash != hash || header->source_size != size ||
+        entry_size(header) != program->file.size) {
+        bytecode_cache_close(program);
+        return 0;
+    }
+
+    const char* cursor = data + sizeof(EntryHeader);
+    Chunk* chunk = &program->chunk;
+    chunk->constants = (Value*)cursor;
+    chunk->constant_count = (int)header->constant_count;
+    chunk->constant_capacity = chunk->constant_count;
+    cursor += (size_t)header->constant_count * sizeof(Value);
+    chunk->code = (uint32_t*)cursor;
+    chunk->count = (int)header->code_count;
+    chunk->capacity = chunk->count;
+    cursor += (size_t)header->code_count * sizeof(uint32_t);
+    chunk->lines = (int*)cursor;
+    cursor += (size_t)header->code_count * sizeof(int32_t);
+    chunk->slot_count = (int)header->slot_count;
+    chunk->max_stack = (int)header->max_stack;
+    program->tokens = (int)header->tokens;
+    program->diagnostics = cursor;
+
+    if (cursor[header->diagnostics_length] != '\0' || !verify_code(chunk)) {
+        bytecode_cache_close(program);
+        return 0;
+    }
+    return 1;
+}
+
+void bytecode_cache_close(CachedProgram* program) {
+    source_close(&program->file);
+    memset(program, 0, sizeof(*program));
+}
+
+int bytecode_cache_store(const char* dir, const char* source, size_t size,
+                         const Chunk* chunk, int tokens, const char* diagnostics) {
+    EntryHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+    header.version = BYTECODE_CACHE_VERSION;
+    header.byte_order = CACHE_BYTE_ORDER;
+    header.source_hash = bytecode_cache_hash(source, size);
+    header.source_size = size;
+    header.value_size = sizeof(Value);
+    header.code_count = (uint32_t)chunk->count;
+    header.constant_count = (uint32_t)chunk->constant_count;
+    header.slot_count = (uint32_t)chunk->slot_count;
+    header.max_stack = (uint32_t)chunk->max_stack;
+    header.tokens = (uint32_t)tokens;
+    header.diagnostics_length = diagnostics ? (uint32_t)strlen(diagnostics) : 0;
+
+    char path[4096], temp[4096 + 16];
+    entry_path(path, sizeof(path), dir, header.source_hash);
+#ifdef CACHE_HAVE_MKSTEMP
+    // Write to a unique temporary and rename it into place, so concurrent
+    // writers and readers never see a partial entry.
+    snprintf(temp, sizeof(temp), "%s.XXXXXX", path);
+    int fd = mkstemp(temp);
+    FILE* file = fd >= 0 ? fdopen(fd, "wb") : NULL;
+    if (!file && fd >= 0) {
+        close(fd);
+    }
+#else
+    snprintf(temp, sizeof(temp), "%s.tmp", path);
+    FILE* file = fopen(temp, "wb");
+#endif
+    if (!file) {
+        return 0;
+    }
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+             fwrite(chunk->constants, sizeof(Value), (size_t)chunk->constant_count, file) == (size_t)chunk->constant_count &&
+             fwrite(chunk->code, sizeof(uint32_t), (size_t)chunk->count, file) == (size_t)chunk->count &&
+             fwrite(chunk->lines, sizeof(int32_t), (size_t)chunk->count, file) == (size_t)chunk->count &&
+             fwrite(diagnostics ? diagnostics : "", 1, header.diagnostics_length + 1, file) == header.diagnostics_length + 1;
+    ok = fclose(file) == 0 && ok;
+    if (ok) {
+#ifndef CACHE_HAVE_MKSTEMP
+        remove(path);  // rename does not replace an existing file everywhere
+#endif
+        ok = rename(temp, path) == 0;
+    }
+    if (!ok) {
+        remove(temp);
+    }
+    return ok;
+}
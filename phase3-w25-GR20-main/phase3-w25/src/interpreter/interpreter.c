@@ -0,0 +1,159 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "../../include/interpreter.h"
+#include "../../include/stats.h"
+
+// -----------------------------------------------------------------
+// Tree-walking interpreter. The statement arrays of AST_PROGRAM and
+// AST_BLOCK are walked iteratively; expressions recurse.
+// -----------------------------------------------------------------
+
+static void exec_statement(Interpreter *interp, ASTNode *node);
+
+// Record a runtime error and unwind to interpreter_run.
+_Noreturn static void runtime_error(Interpreter *interp, RuntimeError error, int line) {
+    interp->error = error;
+    interp->error_line = line;
+    longjmp(interp->on_error, 1);
+}
+
+// Frame slot of a resolved declaration or identifier.
+static Value *slot_of(Interpreter *interp, ASTNode *node) {
+    if (node->slot < 0 || node->slot >= interp->slot_count) {
+        runtime_error(interp, RUNTIME_ERROR_UNRESOLVED_VARIABLE, node->token.line);
+    }
+    return &interp->slots[node->slot];
+}
+
+// Evaluate an expression node.
+static Value eval(Interpreter *interp, ASTNode *node) {
+    switch (node->type) {
+        case AST_NUMBER:
+            return node->token.value;
+        case AST_IDENTIFIER:
+            return *slot_of(interp, node);
+        case AST_FUNCALL:
+            return value_factorial(eval(interp, node->left));
+        case AST_BINOP: {
+            Value a = eval(interp, node->left);
+            Value b = eval(interp, node->right);
+            switch (node->token.id) {
+                case LEXEME_PLUS:  return value_add(a, b);
+                case LEXEME_MINUS: return value_sub(a, b);
+                case LEXEME_STAR:  return value_mul(a, b);
+                case LEXEME_SLASH:
+                    if (b == 0) {
+                        runtime_error(interp, RUNTIME_ERROR_DIVISION_BY_ZERO, node->token.line);
+                    }
+                    return value_div(a, b);
+                case LEXEME_LT:    return a < b;
+                case LEXEME_GT:    return a > b;
+                case LEXEME_LE:    return a <= b;
+                case LEXEME_GE:    return a >= b;
+                case LEXEME_EQ:    return a == b;
+                case LEXEME_NE:    return a != b;
+                default:           return 0;
+            }
+        }
+        default:
+            return 0;
+    }
+}
+
+// Run every statement of an AST_PROGRAM or AST_BLOCK in order.
+static void exec_children(Interpreter *interp, ASTNode *node) {
+    for (int i = 0; i < node->child_count; i++) {
+        exec_statement(interp, node->children[i]);
+    }
+}
+
+// Execute one statement node.
+static void exec_statement(Interpreter *interp, ASTNode *node) {
+    switch (node->type) {
+        case AST_PROGRAM:
+        case AST_BLOCK:
+            exec_children(interp, node);
+            break;
+        case AST_VARDECL:
+            *slot_of(interp, node) = 0;  // Each execution of a declaration starts at 0
+            break;
+        case AST_ASSIGN:
+            *slot_of(interp, node->left) = eval(interp, node->right);
+            break;
+        case AST_PRINT:
+            fprintf(interp->out, "%lld\n", eval(interp, node->left));
+            break;
+        case AST_IF:
+            if (eval(interp, node->left)) {
+                exec_statement(interp, node->right);
+            } else if (node->else_branch) {
+                exec_statement(interp, node->else_branch);
+            }
+            break;
+        case AST_WHILE:
+            while (eval(interp, node->left)) {
+                exec_statement(interp, node->right);
+            }
+            break;
+        case AST_REPEAT:
+            do {
+                exec_statement(interp, node->left);
+            } while (!eval(interp, node->right));
+            break;
+        default:
+            eval(interp, node);  // Expression used as a statement
+            break;
+    }
+}
+
+// Print a runtime error the way the other phases print theirs.
+void print_runtime_error(FILE *out, RuntimeError error, int line) {
+    fprintf(out, "Runtime Error at line %d: ", line);
+    switch (error) {
+        case RUNTIME_ERROR_DIVISION_BY_ZERO:
+            fprintf(out, "Division by zero\n");
+            break;
+        case RUNTIME_ERROR_UNRESOLVED_VARIABLE:
+            fprintf(out, "Variable has no slot (run semantic analysis first)\n");
+            break;
+        case RUNTIME_ERROR_OUT_OF_MEMORY:
+            fprintf(out, "Out of memory\n");
+            break;
+        default:
+            fprintf(out, "Unknown runtime error\n");
+    }
+}
+
+static void report(const Interpreter *interp) {
+    print_runtime_error(interp->out, interp->error, interp->error_line);
+}
+
+int interpreter_run(Interpreter *interp, ASTNode *program, int slot_count, FILE *out) {
+    interp->out = out ? out : stdout;
+    interp->slot_count = slot_count;
+    interp->error = RUNTIME_ERROR_NONE;
+    interp->error_line = 0;
+    interp->slots = (Value *)calloc(slot_count > 0 ? (size_t)slot_count : 1, sizeof(Value));
+    if (!interp->slots) {
+        interp->error = RUNTIME_ERROR_OUT_OF_MEMORY;
+        report(interp);
+        return 0;
+    }
+    STATS_START(timer);
+    if (setjmp(interp->on_error) == 0) {
+        if (program) {
+            exec_statement(interp, program);
+        }
+    } else {
+        report(interp);
+    }
+    STATS_STOP(STATS_RUN, timer);
+    free(interp->slots);
+    interp->slots = NULL;
+    return interp->error == RUNTIME_ERROR_NONE;
+}
+
+int interpret(ASTNode *program, int slot_count, FILE *out) {
+    Interpreter interp;
+    return interpreter_run(&interp, program, slot_count, out);
+}
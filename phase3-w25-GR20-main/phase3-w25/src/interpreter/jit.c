@@ -0,0 +1,337 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/jit.h"
+
+// -----------------------------------------------------------------
+// x86-64 template JIT. Each bytecode instruction becomes a fixed byte
+// sequence: operands live on the native stack (push/pop), rbx holds the
+// slot array, r12 the output stream and rbp the stack pointer at entry.
+// Jumps are emitted as rel32 placeholders and patched once every
+// instruction has an address. The code is written into a read/write
+// mapping that is switched to read/execute before it is run.
+// -----------------------------------------------------------------
+
+#if defined(__x86_64__) && (defined(__unix__) || defined(__APPLE__))
+#define JIT_ENABLED 1
+#include <sys/mman.h>
+#else
+#define JIT_ENABLED 0
+#endif
+
+typedef int (*JitEntry)(Value *slots, FILE *out);
+
+struct JitCode {
+    void *memory;             // Executable mapping
+    size_t size;
+    JitEntry entry;
+};
+
+#if JIT_ENABLED
+
+// Jump targets that are not bytecode instructions.
+#define LABEL_EXIT  (-1)      // Leave the loop normally (returns 0)
+#define LABEL_RETURN (-2)     // Epilogue; eax already holds the result
+
+typedef struct {
+    int at;                   // Offset of the rel32 field
+    int target;               // Instruction index, LABEL_EXIT or LABEL_RETURN
+} Fixup;
+
+typedef struct {
+    unsigned char *bytes;
+    int count;
+    int capacity;
+    Fixup *fixups;
+    int fixup_count;
+    int fixup_capacity;
+    int ok;
+} Assembler;
+
+static void emit_bytes(Assembler *as, const void *bytes, int n) {
+    if (as->count + n > as->capacity) {
+        int capacity = as->capacity ? as->capacity * 2 : 256;
+        while (capacity < as->count + n) {
+            capacity *= 2;
+        }
+        unsigned char *grown = realloc(as->bytes, (size_t)capacity);
+        if (!grown) {
+            as->ok = 0;
+            return;
+        }
+        as->bytes = grown;
+        as->capacity = capacity;
+    }
+    memcpy(as->bytes + as->count, bytes, (size_t)n);
+    as->count += n;
+}
+
+#define EMIT(...) do { \
+        static const unsigned char bytes_[] = {__VA_ARGS__}; \
+        emit_bytes(as, bytes_, (int)sizeof(bytes_)); \
+    } while (0)
+
+static void emit_u32(Assembler *as, uint32_t value) {
+    unsigned char bytes[4];
+    for (int i = 0; i < 4; i++) {
+        bytes[i] = (unsigned char)(value >> (8 * i));
+    }
+    emit_bytes(as, bytes, 4);
+}
+
+static void emit_u64(Assembler *as, uint64_t value) {
+    emit_u32(as, (uint32_t)value);
+    emit_u32(as, (uint32_t)(value >> 32));
+}
+
+// Emit a rel32 field to be patched with the address of `target`.
+static void emit_target(Assembler *as, int target) {
+    if (as->fixup_count == as->fixup_capacity) {
+        int capacity = as->fixup_capacity ? as->fixup_capacity * 2 : 32;
+        Fixup *grown = realloc(as->fixups, (size_t)capacity * sizeof(Fixup));
+        if (!grown) {
+            as->ok = 0;
+            return;
+        }
+        as->fixups = grown;
+        as->fixup_capacity = capacity;
+    }
+    as->fixups[as->fixup_count].at = as->count;
+    as->fixups[as->fixup_count].target = target;
+    as->fixup_count++;
+    emit_u32(as, 0);
+}
+
+// Slot displacement from rbx.
+static void emit_slot(Assembler *as, int slot) {
+    emit_u32(as, (uint32_t)slot * (uint32_t)sizeof(Value));
+}
+
+// Called from generated code for OP_PRINT.
+static void print_value(FILE *out, Value value) {
+    fprintf(out, "%lld\n", value);
+}
+
+// pop rcx; pop rax; cmp rax, rcx; setcc al; movzx eax, al; push rax
+static void emit_compare(Assembler *as, unsigned char setcc) {
+    EMIT(0x59, 0x58, 0x48, 0x39, 0xC8, 0x0F);
+    emit_bytes(as, &setcc, 1);
+    EMIT(0xC0, 0x0F, 0xB6, 0xC0, 0x50);
+}
+
+// Translate one instruction. `depth` is the operand stack depth before it
+// (the loop is entered with an empty stack). Returns 0 if unsupported.
+static int emit_instruction(Assembler *as, const Chunk *chunk, int index, int start, int end,
+                            int *depth) {
+    uint32_t word = chunk->code[index];
+    int arg = BYTECODE_ARG(word);
+    switch (BYTECODE_OP(word)) {
+        case OP_CONST:
+            EMIT(0x48, 0xB8);                           // mov rax, imm64
+            emit_u64(as, (uint64_t)chunk->constants[arg]);
+            EMIT(0x50);                                 // push rax
+            ++*depth;
+            return 1;
+        case OP_LOAD:
+            EMIT(0xFF, 0xB3);                           // push [rbx + disp32]
+            emit_slot(as, arg);
+            ++*depth;
+            return 1;
+        case OP_STORE:
+            EMIT(0x58, 0x48, 0x89, 0x83);               // pop rax; mov [rbx + disp32], rax
+            emit_slot(as, arg);
+            --*depth;
+            return 1;
+        case OP_CLEAR:
+            EMIT(0x48, 0xC7, 0x83);                     // mov qword [rbx + disp32], 0
+            emit_slot(as, arg);
+            emit_u32(as, 0);
+            return 1;
+        case OP_ADD:
+            EMIT(0x59, 0x58, 0x48, 0x01, 0xC8, 0x50);   // add rax, rcx
+            --*depth;
+            return 1;
+        case OP_SUB:
+            EMIT(0x59, 0x58, 0x48, 0x29, 0xC8, 0x50);   // sub rax, rcx
+            --*depth;
+            return 1;
+        case OP_MUL:
+            EMIT(0x59, 0x58, 0x48, 0x0F, 0xAF, 0xC1, 0x50);  // imul rax, rcx
+            --*depth;
+            return 1;
+        case OP_DIV:
+            // pop rcx; pop rax; test rcx, rcx; jnz ok
+            EMIT(0x59, 0x58, 0x48, 0x85, 0xC9, 0x75, 0x0A);
+            EMIT(0xB8);                                 // mov eax, index + 1
+            emit_u32(as, (uint32_t)index + 1);
+            EMIT(0xE9);                                 // jmp return
+            emit_target(as, LABEL_RETURN);
+            // ok: cmp rcx, -1; jne divide; neg rax; jmp done
+            EMIT(0x48, 0x83, 0xF9, 0xFF, 0x75, 0x05, 0x48, 0xF7, 0xD8, 0xEB, 0x05);
+            // divide: cqo; idiv rcx; done: push rax
+            EMIT(0x48, 0x99, 0x48, 0xF7, 0xF9, 0x50);
+            --*depth;
+            return 1;
+        case OP_LT: emit_compare(as, 0x9C); --*depth; return 1;
+        case OP_GT: emit_compare(as, 0x9F); --*depth; return 1;
+        case OP_LE: emit_compare(as, 0x9E); --*depth; return 1;
+        case OP_GE: emit_compare(as, 0x9D); --*depth; return 1;
+        case OP_EQ: emit_compare(as, 0x94); --*depth; return 1;
+        case OP_NE: emit_compare(as, 0x95); --*depth; return 1;
+        case OP_FACTORIAL:
+            // pop rcx; mov eax, 1; mov edx, 2
+            EMIT(0x59, 0xB8, 0x01, 0x00, 0x00, 0x00, 0xBA, 0x02, 0x00, 0x00, 0x00);
+            // loop: cmp rdx, rcx; jg done; imul rax, rdx; inc rdx; jmp loop
+            EMIT(0x48, 0x39, 0xCA, 0x7F, 0x09, 0x48, 0x0F, 0xAF, 0xC2, 0x48, 0xFF, 0xC2, 0xEB, 0xF2);
+            EMIT(0x50);                                 // done: push rax
+            return 1;
+        case OP_PRINT:
+            // The call needs rsp 16-byte aligned, which holds when the stack
+            // is empty after the pop (always the case for a print statement).
+            if (*depth != 1) {
+                return 0;
+            }
+            EMIT(0x5E, 0x4C, 0x89, 0xE7);               // pop rsi; mov rdi, r12
+            EMIT(0x48, 0xB8);                           // mov rax, print_value
+            emit_u64(as, (uint64_t)(uintptr_t)print_value);
+            EMIT(0xFF, 0xD0);                           // call rax
+            --*depth;
+            return 1;
+        case OP_POP:
+            EMIT(0x48, 0x83, 0xC4, 0x08);               // add rsp, 8
+            --*depth;
+            return 1;
+        case OP_JUMP:
+        case OP_JUMP_IF_FALSE:
+        case OP_JUMP_IF_TRUE: {
+            int target = index + 1 + arg;
+            if (target == end + 1) {
+                target = LABEL_EXIT;
+            } else if (target < start || target > end) {
+                return 0;  // Leaves the loop somewhere other than its exit
+            }
+            if (BYTECODE_OP(word) == OP_JUMP) {
+                EMIT(0xE9);                             // jmp rel32
+            } else {
+                EMIT(0x58, 0x48, 0x85, 0xC0);           // pop rax; test rax, rax
+                if (BYTECODE_OP(word) == OP_JUMP_IF_FALSE) {
+                    EMIT(0x0F, 0x84);                   // jz rel32
+                } else {
+                    EMIT(0x0F, 0x85);                   // jnz rel32
+                }
+                --*depth;
+            }
+            emit_target(as, target);
+            return 1;
+        }
+        default:
+            return 0;
+    }
+}
+
+int jit_available(void) {
+    return 1;
+}
+
+JitCode *jit_compile_loop(const Chunk *chunk, int start, int end) {
+    if (start < 0 || end >= chunk->count || start > end) {
+        return NULL;
+    }
+    int *offsets = malloc((size_t)(end - start + 1) * sizeof(int));
+    if (!offsets) {
+        return NULL;
+    }
+    Assembler assembler = {0};
+    Assembler *as = &assembler;
+    as->ok = 1;
+
+    // push rbx; push r12; push rbp; mov rbp, rsp; mov rbx, rdi; mov r12, rsi
+    EMIT(0x53, 0x41, 0x54, 0x55, 0x48, 0x89, 0xE5, 0x48, 0x89, 0xFB, 0x49, 0x89, 0xF4);
+    int depth = 0;
+    int supported = 1;
+    for (int i = start; i <= end && supported; i++) {
+        offsets[i - start] = as->count;
+        supported = emit_instruction(as, chunk, i, start, end, &depth);
+    }
+    int exit_offset = as->count;
+    int return_offset = exit_offset + 2;
+    // exit: xor eax, eax; return: mov rsp, rbp; pop rbp; pop r12; pop rbx; ret
+    EMIT(0x31, 0xC0, 0x48, 0x89, 0xEC, 0x5D, 0x41, 0x5C, 0x5B, 0xC3);
+    if (!supported || depth != 0 || !as->ok) {
+        free(offsets);
+        free(as->bytes);
+        free(as->fixups);
+        return NULL;
+    }
+
+    for (int i = 0; i < as->fixup_count; i++) {
+        int target = as->fixups[i].target;
+        int destination = target == LABEL_EXIT ? exit_offset
+                        : target == LABEL_RETURN ? return_offset
+                        : offsets[target - start];
+        uint32_t rel = (uint32_t)(destination - (as->fixups[i].at + 4));
+        memcpy(as->bytes + as->fixups[i].at, &rel, sizeof(rel));
+    }
+    free(offsets);
+    free(as->fixups);
+
+    size_t size = (size_t)as->count;
+    JitCode *jit = malloc(sizeof(JitCode));
+    void *memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (!jit || memory == MAP_FAILED) {
+        free(jit);
+        free(as->bytes);
+        if (memory != MAP_FAILED) {
+            munmap(memory, size);
+        }
+        return NULL;
+    }
+    memcpy(memory, as->bytes, size);
+    free(as->bytes);
+    if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, size);
+        free(jit);
+        return NULL;
+    }
+    jit->memory = memory;
+    jit->size = size;
+    memcpy(&jit->entry, &memory, sizeof(jit->entry));
+    return jit;
+}
+
+int jit_run(const JitCode *code, Value *slots, FILE *out) {
+    return code->entry(slots, out);
+}
+
+void jit_free(JitCode *code) {
+    if (code) {
+        munmap(code->memory, code->size);
+        free(code);
+    }
+}
+
+#else
+
+int jit_available(void) {
+    return 0;
+}
+
+JitCode *jit_compile_loop(const Chunk *chunk, int start, int end) {
+    (void)chunk;
+    (void)start;
+    (void)end;
+    return NULL;
+}
+
+int jit_run(const JitCode *code, Value *slots, FILE *out) {
+    (void)code;
+    (void)slots;
+    (void)out;
+    return 0;
+}
+
+void jit_free(JitCode *code) {
+    (void)code;
+}
+
+#endif
@@ -0,0 +1,183 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "../../include/bytecode.h"
+#include "../../include/jit.h"
+#include "../../include/stats.h"
+
+// -----------------------------------------------------------------
+// Bytecode VM. With GCC/Clang every handler ends in its own indirect
+// jump through a label table (threaded dispatch), which gives the
+// branch predictor one history per opcode; other compilers fall back
+// to a switch inside a loop. The top of the operand stack is kept in
+// a local so most instructions touch memory at most once.
+//
+// With a JIT threshold, every taken backward jump (the bottom of a while
+// or repeat loop) is counted; when a loop gets hot it is handed to the
+// JIT and from then on runs natively each time it is reached.
+// -----------------------------------------------------------------
+
+#if defined(__GNUC__)
+#define VM_THREADED 1
+#else
+#define VM_THREADED 0
+#endif
+
+typedef struct {
+    int threshold;
+    int *counts;              // Taken count per backward jump (saturates)
+    JitCode **compiled;       // Native loop per backward jump, if any
+} Tiering;
+
+static void tiering_init(Tiering *t, const Chunk *chunk, int threshold) {
+    t->threshold = threshold;
+    t->counts = NULL;
+    t->compiled = NULL;
+    if (threshold <= 0 || !jit_available()) {
+        return;
+    }
+    t->counts = calloc((size_t)chunk->count, sizeof(int));
+    t->compiled = calloc((size_t)chunk->count, sizeof(JitCode *));
+    if (!t->counts || !t->compiled) {
+        free(t->counts);
+        free(t->compiled);
+        t->counts = NULL;
+        t->compiled = NULL;
+    }
+}
+
+static void tiering_free(Tiering *t, const Chunk *chunk) {
+    if (t->compiled) {
+        for (int i = 0; i < chunk->count; i++) {
+            jit_free(t->compiled[i]);
+        }
+    }
+    free(t->counts);
+    free(t->compiled);
+}
+
+// The backward jump at `at` is about to be taken with an empty operand
+// stack. Returns 1 if the loop was run to completion natively, 0 if the VM
+// should take the jump itself, and -1 after printing a runtime error.
+static int tier_up(Tiering *t, const Chunk *chunk, int at, Value *slots, FILE *out) {
+    if (!t->compiled[at]) {
+        if (t->counts[at] >= t->threshold || ++t->counts[at] < t->threshold) {
+            return 0;  // Still cold, or already failed to compile
+        }
+        int start = at + 1 + BYTECODE_ARG(chunk->code[at]);
+        t->compiled[at] = jit_compile_loop(chunk, start, at);
+        if (!t->compiled[at]) {
+            return 0;
+        }
+    }
+    int failed = jit_run(t->compiled[at], slots, out);
+    if (failed) {
+        print_runtime_error(out, RUNTIME_ERROR_DIVISION_BY_ZERO, chunk->lines[failed - 1]);
+        return -1;
+    }
+    return 1;
+}
+
+int vm_run(const Chunk *chunk, FILE *out) {
+    return vm_run_jit(chunk, out, 0);
+}
+
+int vm_run_jit(const Chunk *chunk, FILE *out, int threshold) {
+    STATS_START(timer);
+    if (!out) {
+        out = stdout;
+    }
+    Value *slots = calloc(chunk->slot_count > 0 ? (size_t)chunk->slot_count : 1, sizeof(Value));
+    Value *stack = malloc(((size_t)chunk->max_stack + 1) * sizeof(Value));
+    if (!slots || !stack) {
+        free(slots);
+        free(stack);
+        print_runtime_error(out, RUNTIME_ERROR_OUT_OF_MEMORY, 0);
+        STATS_STOP(STATS_RUN, timer);
+        return 0;
+    }
+
+    const uint32_t *code = chunk->code;
+    const Value *constants = chunk->constants;
+    const uint32_t *pc = code;
+    Value *sp = stack;        // stack[1..] hold values below the cached top
+    Value top = 0;            // Cached top of stack
+    uint32_t word;
+    int ok = 1;
+    Tiering tiering;
+    tiering_init(&tiering, chunk, threshold);
+
+#if VM_THREADED
+    static void *const labels[OP_COUNT] = {
+        &&op_CONST, &&op_LOAD, &&op_STORE, &&op_CLEAR,
+        &&op_ADD, &&op_SUB, &&op_MUL, &&op_DIV,
+        &&op_LT, &&op_GT, &&op_LE, &&op_GE, &&op_EQ, &&op_NE,
+        &&op_FACTORIAL, &&op_PRINT, &&op_POP,
+        &&op_JUMP, &&op_JUMP_IF_FALSE, &&op_JUMP_IF_TRUE, &&op_HALT
+    };
+#define DISPATCH() do { word = *pc++; goto *labels[BYTECODE_OP(word)]; } while (0)
+#define CASE(op) op_##op:
+#define NEXT DISPATCH()
+    DISPATCH();
+#else
+#define CASE(op) case OP_##op:
+#define NEXT break
+    for (;;) {
+        word = *pc++;
+        switch (BYTECODE_OP(word)) {
+#endif
+
+#define ARG BYTECODE_ARG(word)
+#define PUSH(v) do { *++sp = top; top = (v); } while (0)
+#define POP() (top = *sp--)
+#define BINARY(expr) do { Value a = *sp--; Value b = top; (void)b; top = (expr); } while (0)
+#define BRANCH(taken) do { \
+        if (taken) { \
+            int tier = ARG < 0 && tiering.counts && sp == stack \
+                ? tier_up(&tiering, chunk, (int)(pc - 1 - code), slots, out) : 0; \
+            if (tier < 0) { ok = 0; goto done; } \
+            if (tier == 0) pc += ARG; \
+        } \
+    } while (0)
+
+    CASE(CONST)         PUSH(constants[ARG]); NEXT;
+    CASE(LOAD)          PUSH(slots[ARG]); NEXT;
+    CASE(STORE)         slots[ARG] = top; POP(); NEXT;
+    CASE(CLEAR)         slots[ARG] = 0; NEXT;
+    CASE(ADD)           BINARY(value_add(a, b)); NEXT;
+    CASE(SUB)           BINARY(value_sub(a, b)); NEXT;
+    CASE(MUL)           BINARY(value_mul(a, b)); NEXT;
+    CASE(DIV)
+        if (top == 0) {
+            print_runtime_error(out, RUNTIME_ERROR_DIVISION_BY_ZERO, chunk->lines[pc - 1 - code]);
+            ok = 0;
+            goto done;
+        }
+        BINARY(value_div(a, b)); NEXT;
+    CASE(LT)            BINARY(a < b); NEXT;
+    CASE(GT)            BINARY(a > b); NEXT;
+    CASE(LE)            BINARY(a <= b); NEXT;
+    CASE(GE)            BINARY(a >= b); NEXT;
+    CASE(EQ)            BINARY(a == b); NEXT;
+    CASE(NE)            BINARY(a != b); NEXT;
+    CASE(FACTORIAL)     top = value_factorial(top); NEXT;
+    CASE(PRINT)         fprintf(out, "%lld\n", top); POP(); NEXT;
+    CASE(POP)           POP(); NEXT;
+    CASE(JUMP)          pc += ARG; NEXT;
+    CASE(JUMP_IF_FALSE) { Value v = top; POP(); BRANCH(!v); } NEXT;
+    CASE(JUMP_IF_TRUE)  { Value v = top; POP(); BRANCH(v); } NEXT;
+    CASE(HALT)          goto done;
+
+#if !VM_THREADED
+            default:
+                goto done;
+        }
+    }
+#endif
+
+done:
+    tiering_free(&tiering, chunk);
+    free(slots);
+    free(stack);
+    STATS_STOP(STATS_RUN, timer);
+    return ok;
+}
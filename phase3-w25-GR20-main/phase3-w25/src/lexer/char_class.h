@@ -0,0 +1,38 @@
+#ifndef CHAR_CLASS_H
+#define CHAR_CLASS_H
+
+// Character classes used by the lexers in place of the locale-dependent
+// <ctype.h> functions: one table lookup per byte, no function call.
+// Only ASCII letters and digits are classified; bytes >= 0x80 have no class.
+enum {
+    CC_SPACE       = 1,   // ' ', '\t', '\r', '\n'
+    CC_DIGIT       = 2,   // '0'..'9'
+    CC_IDENT_START = 4,   // Letters and '_'
+    CC_IDENT       = 8    // Letters, digits and '_'
+};
+
+static const unsigned char char_class[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0, 0, 1, 0, 0,  /* 0x00 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  /* 0x10 */
+    1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  /* 0x20 */
+    10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 0, 0, 0, 0, 0, 0,  /* 0x30 */
+    0, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,  /* 0x40 */
+    12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 0, 0, 0, 0, 12,  /* 0x50 */
+    0, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,  /* 0x60 */
+    12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 0, 0, 0, 0, 0,  /* 0x70 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  /* 0x80 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  /* 0x90 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  /* 0xA0 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  /* 0xB0 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  /* 0xC0 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  /* 0xD0 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  /* 0xE0 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  /* 0xF0 */
+};
+
+#define IS_SPACE(c)       (char_class[(unsigned char)(c)] & CC_SPACE)
+#define IS_DIGIT(c)       (char_class[(unsigned char)(c)] & CC_DIGIT)
+#define IS_IDENT_START(c) (char_class[(unsigned char)(c)] & CC_IDENT_START)
+#define IS_IDENT(c)       (char_class[(unsigned char)(c)] & CC_IDENT)
+
+#endif /* CHAR_CLASS_H */
@@ -1,55 +1,321 @@
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <ctype.h>
 #include <string.h>
 #include "../../include/tokens.h"
 #include "../../include/lexer.h"
+#include "../../include/diagnostics.h"
+#include "../../include/stats.h"
+#include "char_class.h"
 
-static int current_line = 1;
+// SIMD fast paths scan 16 bytes per step; other targets use the scalar loops.
+#if defined(__GNUC__) && defined(__SSE2__)
+#define LEXER_SIMD 1
+#include <emmintrin.h>
+typedef __m128i Block;
+static inline Block load_block(const char* p) {
+    return _mm_loadu_si128((const __m128i*)p);
+}
+// Bit i set <=> byte i of v equals c.
+static inline unsigned eq_mask(Block v, char c) {
+    return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c)));
+}
+// Bit i set <=> lo <= byte i of v <= hi (unsigned).
+static inline unsigned range_mask(Block v, unsigned char lo, unsigned char hi) {
+    __m128i ge = _mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8((char)lo)), v);
+    __m128i le = _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8((char)hi)), v);
+    return (unsigned)_mm_movemask_epi8(_mm_and_si128(ge, le));
+}
+#elif defined(__GNUC__) && defined(__ARM_NEON) && defined(__aarch64__)
+#define LEXER_SIMD 1
+#include <arm_neon.h>
+typedef uint8x16_t Block;
+static inline Block load_block(const char* p) {
+    return vld1q_u8((const uint8_t*)p);
+}
+// Collapse a 0x00/0xFF lane vector into a 16-bit mask.
+static inline unsigned lane_mask(uint8x16_t lanes) {
+    static const uint8_t bits[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    uint8x16_t picked = vandq_u8(lanes, vld1q_u8(bits));
+    return (unsigned)vaddv_u8(vget_low_u8(picked)) | ((unsigned)vaddv_u8(vget_high_u8(picked)) << 8);
+}
+static inline unsigned eq_mask(Block v, char c) {
+    return lane_mask(vceqq_u8(v, vdupq_n_u8((uint8_t)c)));
+}
+static inline unsigned range_mask(Block v, unsigned char lo, unsigned char hi) {
+    return lane_mask(vandq_u8(vcgeq_u8(v, vdupq_n_u8(lo)), vcleq_u8(v, vdupq_n_u8(hi))));
+}
+#else
+#define LEXER_SIMD 0
+#endif
 
-// Keywords table
-static struct {
-    const char* word;
+// State behind the legacy global API (get_next_token, tokenize, lexer_strings).
+// Context-based callers use their own Lexer and InternTable instead.
+static Lexer default_lexer = {.input = NULL, .line = 1};
+static InternTable strings;
+static int strings_ready = 0;
+
+// Spellings of the LexemeId constants, in enum order.
+static const char* reserved_lexemes[LEXEME_RESERVED_COUNT] = {
+    "", "EOF", "else", "factorial",
+    "if", "while", "repeat", "until", "int", "print",
+    "+", "-", "*", "/", "<", ">", "<=", ">=", "==", "!="
+};
+
+// Keywords table, indexed by KEYWORD_HASH. The hash is perfect and minimal
+// over these eight words, so a candidate needs one slot lookup and a compare
+// of two packed 8-byte words. "else" and "factorial" stay identifiers for the
+// parser but get their reserved IDs here without touching the intern table.
+#define KEYWORD_HASH(length, first) (((length) + 7 * (unsigned char)(first)) & 7)
+#define KEYWORD_MAX_LENGTH 9
+
+static const struct {
+    char word[16];            // Zero-padded spelling
+    int length;
     TokenType type;
-} keywords[] = {
-    {"if", TOKEN_IF},
-    {"while", TOKEN_WHILE},
-    {"repeat", TOKEN_REPEAT},
-    {"until", TOKEN_UNTIL},
-    {"int", TOKEN_INT},
-    {"print", TOKEN_PRINT}
+    LexemeId id;
+} keywords[8] = {
+    [KEYWORD_HASH(2, 'i')] = {"if",        2, TOKEN_IF,         LEXEME_IF},
+    [KEYWORD_HASH(5, 'w')] = {"while",     5, TOKEN_WHILE,      LEXEME_WHILE},
+    [KEYWORD_HASH(6, 'r')] = {"repeat",    6, TOKEN_REPEAT,     LEXEME_REPEAT},
+    [KEYWORD_HASH(5, 'u')] = {"until",     5, TOKEN_UNTIL,      LEXEME_UNTIL},
+    [KEYWORD_HASH(3, 'i')] = {"int",       3, TOKEN_INT,        LEXEME_INT},
+    [KEYWORD_HASH(5, 'p')] = {"print",     5, TOKEN_PRINT,      LEXEME_PRINT},
+    [KEYWORD_HASH(4, 'e')] = {"else",      4, TOKEN_IDENTIFIER, LEXEME_ELSE},
+    [KEYWORD_HASH(9, 'f')] = {"factorial", 9, TOKEN_IDENTIFIER, LEXEME_FACTORIAL}
 };
 
-static int is_keyword(const char* word) {
-    for (int i = 0; i < sizeof(keywords) / sizeof(keywords[0]); i++) {
-        if (strcmp(word, keywords[i].word) == 0) {
-            return keywords[i].type;
+// Classify the identifier text[0..length). Returns the keyword slot, or -1.
+static int find_keyword(const char* text, int length) {
+    if (length < 2 || length > KEYWORD_MAX_LENGTH) {
+        return -1;
+    }
+    int slot = KEYWORD_HASH(length, text[0]);
+    if (keywords[slot].length != length) {
+        return -1;
+    }
+    char padded[16] = {0};
+    memcpy(padded, text, (size_t)length);
+    unsigned long long a[2], b[2];
+    memcpy(a, padded, sizeof(a));
+    memcpy(b, keywords[slot].word, sizeof(b));
+    return (a[0] == b[0] && a[1] == b[1]) ? slot : -1;
+}
+
+// Initialize a string table and pre-intern the reserved lexemes so that
+// their IDs match the LexemeId enum.
+int lexer_init_strings(InternTable* table) {
+    intern_init(table);
+    for (int i = 0; i < LEXEME_RESERVED_COUNT; i++) {
+        if (intern(table, reserved_lexemes[i], strlen(reserved_lexemes[i])) != (unsigned int)i) {
+            intern_free(table);  // Later ids would not match the LexemeIds
+            return 0;
         }
     }
-    return 0;
+    return 1;
 }
 
-void print_error(ErrorType error, int line, const char* lexeme) {
-    printf("Lexical Error at line %d: ", line);
-    switch(error) {
-        case ERROR_INVALID_CHAR:
-            printf("Invalid character '%s'\n", lexeme);
-            break;
-        case ERROR_INVALID_NUMBER:
-            printf("Invalid number format\n");
-            break;
-        case ERROR_CONSECUTIVE_OPERATORS:
-            printf("Consecutive operators not allowed\n");
-            break;
-        case ERROR_INVALID_IDENTIFIER:
-            printf("Invalid identifier\n");
-            break;
-        case ERROR_UNEXPECTED_TOKEN:
-            printf("Unexpected token '%s'\n", lexeme);
-            break;
-        default:
-            printf("Unknown error\n");
+InternTable* lexer_strings(void) {
+    if (!strings_ready) {
+        lexer_init_strings(&strings);
+        strings_ready = 1;
+    }
+    return &strings;
+}
+
+void lexer_free_strings(void) {
+    if (strings_ready) {
+        intern_free(&strings);
+        strings_ready = 0;
+    }
+}
+
+// Start lexing `input` from the beginning. Lexemes are interned into `table`,
+// which must have been set up with lexer_init_strings.
+void lexer_init(Lexer* lexer, const char* input, InternTable* table) {
+    lexer->input = input;
+    lexer->length = (int)strlen(input);
+    lexer->pos = 0;
+    lexer->line = 1;
+    lexer->line_start = 0;
+    lexer->strings = table;
+    lexer->scalar_only = 0;
+}
+
+// -----------------------------------------------------------------
+// Run scanners. Each returns the offset of the first byte past the run.
+// The SIMD loops only read whole blocks that lie before lexer->length;
+// the scalar loops finish the tail. No loop crosses the '\0' terminator.
+// -----------------------------------------------------------------
+
+#if LEXER_SIMD
+// Account for the newlines at the set bits of `newlines` in the block at `pos`.
+static inline void count_newlines(Lexer* lexer, int pos, unsigned newlines) {
+    if (newlines) {
+        lexer->line += __builtin_popcount(newlines);
+        lexer->line_start = pos + 32 - __builtin_clz(newlines);  // Just past the last one
+    }
+}
+#endif
+
+// Skip spaces, tabs, carriage returns and newlines, counting lines.
+static int skip_whitespace(Lexer* lexer, int pos) {
+    const char* input = lexer->input;
+#if LEXER_SIMD
+    if (!lexer->scalar_only && IS_SPACE(input[pos])) {
+        while (pos + 16 <= lexer->length) {
+            Block v = load_block(input + pos);
+            unsigned newlines = eq_mask(v, '\n');
+            unsigned spaces = eq_mask(v, ' ') | eq_mask(v, '\t') | eq_mask(v, '\r') | newlines;
+            if (spaces != 0xFFFF) {
+                unsigned run = (unsigned)__builtin_ctz(~spaces);
+                count_newlines(lexer, pos, newlines & ((1u << run) - 1));
+                return pos + (int)run;
+            }
+            count_newlines(lexer, pos, newlines);
+            pos += 16;
+        }
+    }
+#endif
+    while (IS_SPACE(input[pos])) {
+        if (input[pos] == '\n') {
+            lexer->line++;
+            lexer->line_start = pos + 1;
+        }
+        pos++;
     }
+    return pos;
+}
+
+// Skip the rest of a block comment (pos is just past "/*"), counting lines.
+// Returns the offset after "*/", or of the terminator if the comment is unclosed.
+static int skip_comment_body(Lexer* lexer, int pos) {
+    const char* input = lexer->input;
+#if LEXER_SIMD
+    if (!lexer->scalar_only) {
+        while (pos + 17 <= lexer->length) {
+            Block v = load_block(input + pos);
+            unsigned ends = eq_mask(v, '*') & eq_mask(load_block(input + pos + 1), '/');
+            unsigned nul = eq_mask(v, '\0');  // Never scan past the terminator
+            if (nul && (!ends || __builtin_ctz(nul) < __builtin_ctz(ends))) {
+                break;
+            }
+            unsigned newlines = eq_mask(v, '\n');
+            if (ends) {
+                unsigned at = (unsigned)__builtin_ctz(ends);
+                count_newlines(lexer, pos, newlines & ((1u << at) - 1));
+                return pos + (int)at + 2;
+            }
+            count_newlines(lexer, pos, newlines);
+            pos += 16;
+        }
+    }
+#endif
+    while (input[pos] != '\0' && !(input[pos] == '*' && input[pos + 1] == '/')) {
+        if (input[pos] == '\n') {
+            lexer->line++;
+            lexer->line_start = pos + 1;
+        }
+        pos++;
+    }
+    return input[pos] != '\0' ? pos + 2 : pos;
+}
+
+// Scan a run of decimal digits.
+static int scan_digits(const Lexer* lexer, int pos) {
+    const char* input = lexer->input;
+#if LEXER_SIMD
+    if (!lexer->scalar_only) {
+        while (pos + 16 <= lexer->length) {
+            unsigned digits = range_mask(load_block(input + pos), '0', '9');
+            if (digits != 0xFFFF) {
+                return pos + __builtin_ctz(~digits);
+            }
+            pos += 16;
+        }
+    }
+#endif
+    while (IS_DIGIT(input[pos])) {
+        pos++;
+    }
+    return pos;
+}
+
+// Scan a run of identifier characters (letters, digits, '_').
+static int scan_identifier(const Lexer* lexer, int pos) {
+    const char* input = lexer->input;
+#if LEXER_SIMD
+    if (!lexer->scalar_only) {
+        while (pos + 16 <= lexer->length) {
+            Block v = load_block(input + pos);
+            unsigned ident = range_mask(v, 'a', 'z') | range_mask(v, 'A', 'Z') |
+                             range_mask(v, '0', '9') | eq_mask(v, '_');
+            if (ident != 0xFFFF) {
+                return pos + __builtin_ctz(~ident);
+            }
+            pos += 16;
+        }
+    }
+#endif
+    while (IS_IDENT(input[pos])) {
+        pos++;
+    }
+    return pos;
+}
+
+// Point the token at the interned copy of input[start..start+length).
+static void set_lexeme(Lexer* lexer, Token* token, int start, int length) {
+    token->id = intern(lexer->strings, lexer->input + start, length);
+    token->lexeme = intern_string(lexer->strings, token->id);
+}
+
+// Decimal value of a digit string, or -1 if it does not fit in a long long.
+static long long decimal_value(const char* digits, int length) {
+    unsigned long long value = 0;
+    for (int i = 0; i < length; i++) {
+        unsigned long long digit = (unsigned long long)(digits[i] - '0');
+        if (value > (LLONG_MAX - digit) / 10) {
+            return -1;
+        }
+        value = value * 10 + digit;
+    }
+    return (long long)value;
+}
+
+// Intern a number literal. Its value is computed the first time its text
+// is seen and kept on the intern entry, so each distinct literal is
+// converted once and every later token (and token_at) just reads it.
+// A literal too large for a long long keeps -1 there and becomes an
+// ERROR_INVALID_NUMBER token, so the program is rejected rather than run
+// with some other constant.
+static void set_number_lexeme(Lexer* lexer, Token* token, int start, int length) {
+    unsigned int seen = lexer->strings->count;
+    set_lexeme(lexer, token, start, length);
+    if (token->id >= lexer->strings->count) {
+        return;  // Out of memory; the token keeps value 0
+    }
+    InternEntry* entry = &lexer->strings->entries[token->id];
+    if (token->id >= seen) {
+        entry->value = decimal_value(lexer->input + start, length);
+    }
+    if (entry->value < 0) {
+        token->type = TOKEN_ERROR;
+        token->error = ERROR_INVALID_NUMBER;
+        return;
+    }
+    token->value = entry->value;
+}
+
+// Point the token at one of the reserved lexemes.
+static void set_reserved_lexeme(Lexer* lexer, Token* token, LexemeId id) {
+    token->id = id;
+    token->lexeme = intern_string(lexer->strings, id);
+}
+
+// Print a lexical error to stdout, as the text diagnostics format shows it.
+void print_error(ErrorType error, int line, const char* lexeme) {
+    Diagnostic diagnostic = {DIAGNOSTIC_LEXICAL, error, line, 0, lexeme ? lexeme : ""};
+    diagnostics_print(&diagnostic, 1, DIAGNOSTICS_TEXT, NULL, stdout);
 }
 
 void print_token(Token token) {
@@ -80,73 +346,73 @@ void print_token(Token token) {
     printf(" | Lexeme: '%s' | Line: %d\n", token.lexeme, token.line);
 }
 
+// Legacy entry point: lex from `input` at *pos using the default lexer.
 Token get_next_token(const char* input, int* pos) {
-    Token token = {TOKEN_ERROR, "", current_line, ERROR_NONE};
+    if (default_lexer.input != input) {
+        default_lexer.input = input;
+        default_lexer.length = (int)strlen(input);
+    }
+    default_lexer.pos = *pos;
+    default_lexer.strings = lexer_strings();
+    Token token = lexer_next_token(&default_lexer);
+    *pos = default_lexer.pos;
+    if (token.type == TOKEN_EOF) {
+        default_lexer.line = 1;  // The next input starts over
+        default_lexer.line_start = 0;
+    }
+    return token;
+}
+
+// Scan the next token; all state lives in `lexer`, so separate lexers may run concurrently.
+Token lexer_next_token(Lexer* lexer) {
+    const char* input = lexer->input;
+    int* pos = &lexer->pos;
+    Token token = {TOKEN_ERROR, "", LEXEME_EMPTY, lexer->line, 0, ERROR_NONE, 0};
     char c;
+    STATS_COUNT(tokens, 1);
     
     // Skip whitespace and update line count.
     // Also, skip over block comments "/* ... */"
     while (1) {
-        // Skip whitespace
-        while ((c = input[*pos]) != '\0' && (c == ' ' || c == '\n' || c == '\t')) {
-            if (c == '\n') {
-                current_line++;
-            }
-            (*pos)++;
-        }
+        // Skip whitespace ('\r' included, so CRLF sources need no rewriting)
+        *pos = skip_whitespace(lexer, *pos);
         // Check for block comment start "/*"
         if (input[*pos] == '/' && input[*pos + 1] == '*') {
-            (*pos) += 2;  // Skip "/*"
-            while (input[*pos] != '\0' && !(input[*pos] == '*' && input[*pos + 1] == '/')) {
-                if (input[*pos] == '\n') {
-                    current_line++;
-                }
-                (*pos)++;
-            }
-            if (input[*pos] != '\0') {
-                (*pos) += 2;  // Skip closing "*/"
-            }
+            *pos = skip_comment_body(lexer, *pos + 2);  // Also skips the closing "*/"
             continue;  // After skipping the comment, start over.
         }
         break;
     }
+    token.line = lexer->line;  // The line the lexeme starts on, not where skipping began
+    token.column = *pos - lexer->line_start + 1;
     
     if (input[*pos] == '\0') {
         token.type = TOKEN_EOF;
-        strcpy(token.lexeme, "EOF");
-        current_line = 0;
+        set_reserved_lexeme(lexer, &token, LEXEME_EOF);
         return token;
     }
     
     c = input[*pos];
+    int start = *pos;
     
     // Handle numbers
-    if (isdigit(c)) {
-        int i = 0;
-        do {
-            token.lexeme[i++] = c;
-            (*pos)++;
-            c = input[*pos];
-        } while (isdigit(c) && i < sizeof(token.lexeme) - 1);
-        token.lexeme[i] = '\0';
+    if (IS_DIGIT(c)) {
+        *pos = scan_digits(lexer, *pos + 1);
         token.type = TOKEN_NUMBER;
+        set_number_lexeme(lexer, &token, start, *pos - start);
         return token;
     }
     
     // Handle identifiers and keywords
-    if (isalpha(c) || c == '_') {
-        int i = 0;
-        do {
-            token.lexeme[i++] = c;
-            (*pos)++;
-            c = input[*pos];
-        } while ((isalnum(c) || c == '_') && i < sizeof(token.lexeme) - 1);
-        token.lexeme[i] = '\0';
-        // Check if it's a keyword
-        TokenType keyword_type = is_keyword(token.lexeme);
-        if (keyword_type) {
-            token.type = keyword_type;
+    if (IS_IDENT_START(c)) {
+        *pos = scan_identifier(lexer, *pos + 1);
+        // Keywords use their reserved lexeme; everything else is interned
+        int keyword = find_keyword(input + start, *pos - start);
+        if (keyword >= 0) {
+            set_reserved_lexeme(lexer, &token, keywords[keyword].id);
+            token.type = keywords[keyword].type;
         } else {
+            set_lexeme(lexer, &token, start, *pos - start);
             token.type = TOKEN_IDENTIFIER;
         }
         return token;
@@ -154,8 +420,6 @@ Token get_next_token(const char* input, int* pos) {
     
     // Handle operators and delimiters
     (*pos)++;
-    token.lexeme[0] = c;
-    token.lexeme[1] = '\0';
     switch(c) {
         case '+': case '-': case '*': case '/':
             token.type = TOKEN_OPERATOR;
@@ -163,21 +427,18 @@ Token get_next_token(const char* input, int* pos) {
         case '>':
             if (input[*pos] == '=') {
                 (*pos)++;
-                strcpy(token.lexeme, ">=");
             }
             token.type = TOKEN_OPERATOR;
             break;
         case '<':
             if (input[*pos] == '=') {
                 (*pos)++;
-                strcpy(token.lexeme, "<=");
             }
             token.type = TOKEN_OPERATOR;
             break;
         case '=':
             if (input[*pos] == '=') {
                 (*pos)++;
-                strcpy(token.lexeme, "==");
                 token.type = TOKEN_OPERATOR;
             } else {
                 token.type = TOKEN_EQUALS;
@@ -202,5 +463,107 @@ Token get_next_token(const char* input, int* pos) {
             token.error = ERROR_INVALID_CHAR;
             break;
     }
+    set_lexeme(lexer, &token, start, *pos - start);
+    return token;
+}
+
+// Grow every array of the token buffer to hold at least one more token.
+static int reserve_token(TokenBuffer* tokens) {
+    if (tokens->count < tokens->capacity) {
+        return 1;
+    }
+    int capacity = tokens->capacity ? tokens->capacity * 2 : 256;
+    unsigned char* types = realloc(tokens->types, capacity);
+    if (types) tokens->types = types;
+    unsigned char* errors = realloc(tokens->errors, capacity);
+    if (errors) tokens->errors = errors;
+    int* lines = realloc(tokens->lines, capacity * sizeof(int));
+    if (lines) tokens->lines = lines;
+    int* columns = realloc(tokens->columns, capacity * sizeof(int));
+    if (columns) tokens->columns = columns;
+    int* offsets = realloc(tokens->offsets, capacity * sizeof(int));
+    if (offsets) tokens->offsets = offsets;
+    unsigned int* ids = realloc(tokens->ids, capacity * sizeof(unsigned int));
+    if (ids) tokens->ids = ids;
+    if (!types || !errors || !lines || !columns || !offsets || !ids) {
+        return 0;
+    }
+    tokens->capacity = capacity;
+    return 1;
+}
+
+// Lex the whole input into `tokens` (replacing its contents) using the default string table.
+int tokenize(const char* input, TokenBuffer* tokens) {
+    Lexer lexer;
+    lexer_init(&lexer, input, lexer_strings());
+    return lexer_tokenize(&lexer, tokens);
+}
+
+// Lex everything left in `lexer` into `tokens` (replacing its contents), ending with TOKEN_EOF.
+int lexer_tokenize(Lexer* lexer, TokenBuffer* tokens) {
+    tokens->count = 0;
+    tokens->strings = lexer->strings;
+    STATS_START(timer);
+    while (1) {
+        if (!reserve_token(tokens)) {
+            STATS_STOP(STATS_LEX, timer);
+            return 0;
+        }
+        // Skipped whitespace and comments belong to no token, so record the
+        // offset where get_next_token actually started the lexeme.
+        Token token = lexer_next_token(lexer);
+        if (token.id >= lexer->strings->count) {
+            STATS_STOP(STATS_LEX, timer);
+            return 0;  // intern ran out of memory: the lexeme has no entry
+        }
+        int i = tokens->count++;
+        tokens->types[i] = (unsigned char)token.type;
+        tokens->errors[i] = (unsigned char)token.error;
+        tokens->lines[i] = token.line;
+        tokens->columns[i] = token.column;
+        tokens->ids[i] = token.id;
+        tokens->offsets[i] = lexer->pos - (int)lexer->strings->entries[token.id].length;
+        if (token.type == TOKEN_EOF) {
+            tokens->offsets[i] = lexer->pos;
+            STATS_STOP(STATS_LEX, timer);
+            return 1;
+        }
+    }
+}
+
+// Rebuild the Token at `index`; anything past the end is the final EOF token.
+Token token_at(const TokenBuffer* tokens, int index) {
+    Token token;
+    if (tokens->count == 0) {
+        // Lexing failed before the first token: an empty program.
+        token.type = TOKEN_EOF;
+        token.error = ERROR_NONE;
+        token.line = 1;
+        token.column = 1;
+        token.id = LEXEME_EOF;
+        token.lexeme = tokens->strings ? intern_string(tokens->strings, LEXEME_EOF) : "EOF";
+        token.value = 0;
+        return token;
+    }
+    if (index >= tokens->count) {
+        index = tokens->count - 1;
+    }
+    token.type = (TokenType)tokens->types[index];
+    token.error = (ErrorType)tokens->errors[index];
+    token.line = tokens->lines[index];
+    token.column = tokens->columns[index];
+    token.id = tokens->ids[index];
+    token.lexeme = intern_string(tokens->strings, token.id);
+    token.value = token.id < tokens->strings->count ? tokens->strings->entries[token.id].value : 0;
     return token;
 }
+
+void free_token_buffer(TokenBuffer* tokens) {
+    free(tokens->types);
+    free(tokens->errors);
+    free(tokens->lines);
+    free(tokens->columns);
+    free(tokens->offsets);
+    free(tokens->ids);
+    memset(tokens, 0, sizeof(*tokens));
+}
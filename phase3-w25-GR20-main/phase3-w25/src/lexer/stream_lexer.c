@@ -0,0 +1,158 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/tokens.h"
+#include "../../include/lexer.h"
+#include "char_class.h"
+
+// The streaming lexer keeps a window of the input and makes sure that, before
+// the core scanner (lexer_next_token) runs, the window starts exactly at a
+// token and contains all of it. Whitespace and comments are skipped here,
+// refilling as needed, so they never have to be held in memory.
+
+#define STREAM_DEFAULT_CHUNK (64 * 1024)
+
+static size_t read_file_chunk(void* user, char* buffer, size_t capacity) {
+    return fread(buffer, 1, capacity, (FILE*)user);
+}
+
+int stream_lexer_init(StreamLexer* stream, LexerReadFn read, void* user,
+                      size_t chunk_size, InternTable* table) {
+    memset(stream, 0, sizeof(*stream));
+    stream->read = read;
+    stream->user = user;
+    stream->chunk_size = chunk_size ? chunk_size : STREAM_DEFAULT_CHUNK;
+    stream->capacity = stream->chunk_size;
+    stream->buffer = malloc(stream->capacity + 1);
+    if (!stream->buffer) {
+        return 0;
+    }
+    stream->buffer[0] = '\0';
+    lexer_init(&stream->lexer, stream->buffer, table);
+    return 1;
+}
+
+int stream_lexer_init_file(StreamLexer* stream, FILE* file, size_t chunk_size, InternTable* table) {
+    return stream_lexer_init(stream, read_file_chunk, file, chunk_size, table);
+}
+
+void stream_lexer_destroy(StreamLexer* stream) {
+    free(stream->buffer);
+    memset(stream, 0, sizeof(*stream));
+}
+
+long long stream_lexer_offset(const StreamLexer* stream) {
+    return stream->base_offset + stream->lexer.pos;
+}
+
+// Drop everything before the read position, then read one more chunk.
+// Returns 0 once the input is exhausted.
+static int refill(StreamLexer* stream) {
+    if (stream->eof) {
+        return 0;
+    }
+    size_t pos = (size_t)stream->lexer.pos;
+    if (pos > 0) {
+        memmove(stream->buffer, stream->buffer + pos, stream->length - pos);
+        stream->length -= pos;
+        stream->base_offset += pos;
+        stream->lexer.pos = 0;
+        stream->lexer.line_start -= (int)pos;
+    }
+    // Grow only when a single token no longer fits next to a full chunk.
+    if (stream->capacity - stream->length < stream->chunk_size) {
+        size_t capacity = stream->length + stream->chunk_size;
+        char* buffer = realloc(stream->buffer, capacity + 1);
+        if (!buffer) {
+            stream->eof = 1;
+            return 0;
+        }
+        stream->buffer = buffer;
+        stream->capacity = capacity;
+    }
+    size_t read = stream->read(stream->user, stream->buffer + stream->length,
+                               stream->capacity - stream->length);
+    stream->length += read;
+    stream->buffer[stream->length] = '\0';
+    stream->lexer.input = stream->buffer;
+    stream->lexer.length = (int)stream->length;
+    if (read == 0) {
+        stream->eof = 1;
+        return 0;
+    }
+    return 1;
+}
+
+// Make at least `count` unread bytes available unless the input ends first.
+static void ensure(StreamLexer* stream, size_t count) {
+    while (stream->length - (size_t)stream->lexer.pos < count && refill(stream)) {
+    }
+}
+
+// Skip whitespace and block comments, counting lines, across any number of refills.
+static void skip_trivia(StreamLexer* stream) {
+    Lexer* lexer = &stream->lexer;
+    while (1) {
+        ensure(stream, 2);
+        char c = stream->buffer[lexer->pos];
+        if (IS_SPACE(c)) {
+            if (c == '\n') {
+                lexer->line++;
+                lexer->line_start = lexer->pos + 1;
+            }
+            lexer->pos++;
+            continue;
+        }
+        if (c == '/' && stream->buffer[lexer->pos + 1] == '*') {
+            lexer->pos += 2;  // Skip "/*"
+            while (1) {
+                ensure(stream, 2);
+                const char* p = stream->buffer + lexer->pos;
+                if (p[0] == '\0') {
+                    return;  // Unterminated comment runs to end of input
+                }
+                if (p[0] == '*' && p[1] == '/') {
+                    lexer->pos += 2;  // Skip closing "*/"
+                    break;
+                }
+                if (p[0] == '\n') {
+                    lexer->line++;
+                    lexer->line_start = lexer->pos + 1;
+                }
+                lexer->pos++;
+            }
+            continue;
+        }
+        return;
+    }
+}
+
+// Refill until the identifier or number starting at the read position ends
+// inside the window (or the input ends).
+static void ensure_run(StreamLexer* stream, int identifier) {
+    size_t scanned = 1;
+    while (1) {
+        const char* p = stream->buffer + stream->lexer.pos;
+        size_t available = stream->length - (size_t)stream->lexer.pos;
+        while (scanned < available &&
+               (identifier ? IS_IDENT(p[scanned]) : IS_DIGIT(p[scanned]))) {
+            scanned++;
+        }
+        if (scanned < available || !refill(stream)) {
+            return;
+        }
+    }
+}
+
+Token stream_lexer_next(StreamLexer* stream) {
+    skip_trivia(stream);
+    char c = stream->buffer[stream->lexer.pos];
+    if (IS_DIGIT(c)) {
+        ensure_run(stream, 0);
+    } else if (IS_IDENT_START(c)) {
+        ensure_run(stream, 1);
+    } else {
+        ensure(stream, 2);  // Two-character operators
+    }
+    return lexer_next_token(&stream->lexer);
+}
@@ -0,0 +1,49 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "../include/parser.h"
+#include "../include/source.h"
+
+// -----------------------------------------------------------------
+// Main Function for Testing
+// -----------------------------------------------------------------
+int main() {
+    const char *valid_filename = "phase3-w25/test/input_valid.txt";
+    const char *invalid_filename = "phase3-w25/test/input_invalid.txt";    
+
+    printf("Parsing valid input from %s:\n", valid_filename);
+    SourceFile valid_source;
+    if (source_open(&valid_source, valid_filename)) {
+        const char *valid_input = valid_source.data;
+        printf("Input:\n%s\n", valid_input);
+        parser_init(valid_input);
+        ASTNode *ast = parse();
+        if (ast) {
+            printf("\nAbstract Syntax Tree for valid input:\n");
+            print_ast(ast, 0);
+            free_ast(ast);
+        } else {
+            printf("Error parsing valid input.\n");
+        }
+        source_close(&valid_source);
+    }
+
+    printf("\nParsing invalid input from %s:\n", invalid_filename);
+    SourceFile invalid_source;
+    if (source_open(&invalid_source, invalid_filename)) {
+        const char *invalid_input = invalid_source.data;
+        printf("Input:\n%s\n", invalid_input);
+        parser_init(invalid_input);
+        ASTNode *ast = parse();
+        if (!ast) {
+            printf("Error parsing invalid input as expected.\n");
+        } else {
+            printf("\nAbstract Syntax Tree for invalid input (unexpected):\n");
+            print_ast(ast, 0);
+            free_ast(ast);
+        }
+        source_close(&invalid_source);
+    }
+
+    parser_cleanup();
+    return 0;
+}
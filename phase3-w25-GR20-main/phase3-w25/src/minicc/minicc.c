@@ -0,0 +1,120 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/parser.h"
+#include "../../include/semantic.h"
+#include "../../include/source.h"
+#include "../../include/optimizer.h"
+#include "../../include/codegen.h"
+
+// -----------------------------------------------------------------
+// Ahead-of-time compiler: check and fold one source file, lower it to C
+// and hand that to the system C compiler to build a native executable.
+// -----------------------------------------------------------------
+
+static void usage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s [-o output] [--emit-c] [--cc compiler] [--keep-c] file\n"
+            "  -o FILE       output executable (or C file with --emit-c); default a.out\n"
+            "  --emit-c      write the generated C instead of building it ('-' = stdout)\n"
+            "  --cc CC       C compiler to run (default: $CC, then cc)\n"
+            "  --keep-c      keep the intermediate FILE.c next to the executable\n",
+            program);
+}
+
+int main(int argc, char** argv) {
+    const char* path = NULL;
+    const char* output = NULL;
+    const char* compiler = getenv("CC");
+    int emit_only = 0;
+    int keep_c = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else if (strcmp(argv[i], "--cc") == 0 && i + 1 < argc) {
+            compiler = argv[++i];
+        } else if (strcmp(argv[i], "--emit-c") == 0) {
+            emit_only = 1;
+        } else if (strcmp(argv[i], "--keep-c") == 0) {
+            keep_c = 1;
+        } else if (argv[i][0] == '-' || path) {
+            usage(argv[0]);
+            return 2;
+        } else {
+            path = argv[i];
+        }
+    }
+    if (!path) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (!compiler || !compiler[0]) {
+        compiler = "cc";
+    }
+    if (!output) {
+        output = emit_only ? "-" : "a.out";
+    }
+
+    SourceFile source;
+    if (!source_open(&source, path)) {
+        return 1;
+    }
+    Parser parser = {0};
+    if (!parser_context_init(&parser, source.data)) {
+        fprintf(stderr, "%s: out of memory\n", path);
+        parser_context_destroy(&parser);
+        source_close(&source);
+        return 1;
+    }
+    ASTNode* ast = parser_context_parse(&parser);
+    diagnostics_print(parser.diagnostics.items, parser.diagnostics.count, DIAGNOSTICS_TEXT, NULL, stderr);
+    int slot_count = 0;
+    if (!ast || !analyze_semantics_slots(ast, stderr, 0, &slot_count)) {
+        parser_context_destroy(&parser);
+        source_close(&source);
+        return 1;
+    }
+    fold_constants(ast, &parser.strings, NULL);
+
+    // Write the C translation unit.
+    char c_path[4096];
+    if (emit_only) {
+        snprintf(c_path, sizeof(c_path), "%s", output);
+    } else {
+        snprintf(c_path, sizeof(c_path), "%s.c", output);
+    }
+    int to_stdout = emit_only && strcmp(c_path, "-") == 0;
+    FILE* c_file = to_stdout ? stdout : fopen(c_path, "w");
+    if (!c_file) {
+        perror(c_path);
+        parser_context_destroy(&parser);
+        source_close(&source);
+        return 1;
+    }
+    int ok = codegen_emit_c(ast, slot_count, c_file);
+    if (!to_stdout && fclose(c_file) != 0) {
+        ok = 0;
+    }
+    parser_context_destroy(&parser);
+    source_close(&source);
+    if (!ok) {
+        fprintf(stderr, "Error: could not generate C for %s\n", path);
+        return 1;
+    }
+    if (emit_only) {
+        return 0;
+    }
+
+    // Build it.
+    char command[3 * 4096];
+    snprintf(command, sizeof(command), "%s -O2 -o \"%s\" \"%s\"", compiler, output, c_path);
+    int status = system(command);
+    if (!keep_c) {
+        remove(c_path);
+    }
+    if (status != 0) {
+        fprintf(stderr, "Error: '%s' failed\n", command);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,271 @@
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/cfg.h"
+#include "../../include/ast_visit.h"
+
+// -----------------------------------------------------------------
+// Control flow graph construction and bit-vector dataflow. The graph is
+// built in one walk over the statements: every if, while and repeat ends
+// its current block and leaves a fresh empty one behind, so the statements
+// appended to a block are always contiguous. Liveness is then iterated
+// over the whole graph until no set changes.
+// -----------------------------------------------------------------
+
+// Sets per block: live_out, and while solving the use and def summaries.
+enum { SETS_KEPT = 1, SETS_SCRATCH = 2 };
+
+typedef struct {
+    Cfg* cfg;
+    int current;              // Block receiving statements
+    int failed;               // Out of memory
+} Builder;
+
+// Start a new, empty block; returns its index (CFG_NONE on out-of-memory).
+static int new_block(Builder* b) {
+    Cfg* cfg = b->cfg;
+    if (cfg->block_count == cfg->block_capacity) {
+        int capacity = cfg->block_capacity ? cfg->block_capacity * 2 : 16;
+        CfgBlock* blocks = realloc(cfg->blocks, (size_t)capacity * sizeof(CfgBlock));
+        if (!blocks) {
+            b->failed = 1;
+            return CFG_NONE;
+        }
+        cfg->blocks = blocks;
+        cfg->block_capacity = capacity;
+    }
+    CfgBlock* block = &cfg->blocks[cfg->block_count];
+    block->first = cfg->statement_count;
+    block->count = 0;
+    block->condition = NULL;
+    block->successors[0] = CFG_NONE;
+    block->successors[1] = CFG_NONE;
+    block->live_out = NULL;
+    return cfg->block_count++;
+}
+
+// Append a straight-line statement to the current block.
+static void append_statement(Builder* b, ASTNode* node) {
+    Cfg* cfg = b->cfg;
+    if (cfg->statement_count == cfg->statement_capacity) {
+        int capacity = cfg->statement_capacity ? cfg->statement_capacity * 2 : 64;
+        ASTNode** statements = realloc(cfg->statements, (size_t)capacity * sizeof(ASTNode*));
+        if (!statements) {
+            b->failed = 1;
+            return;
+        }
+        cfg->statements = statements;
+        cfg->statement_capacity = capacity;
+    }
+    cfg->statements[cfg->statement_count++] = node;
+    cfg->blocks[b->current].count++;
+}
+
+// End the current block with `condition` and an edge into a new block,
+// which becomes current. Returns the ended block (CFG_NONE on failure).
+static int branch_into_new(Builder* b, ASTNode* condition) {
+    int from = b->current;
+    int to = new_block(b);
+    if (to == CFG_NONE) {
+        return CFG_NONE;
+    }
+    b->cfg->blocks[from].condition = condition;
+    b->cfg->blocks[from].successors[0] = to;
+    b->current = to;
+    return from;
+}
+
+static void build_statement(Builder* b, ASTNode* node) {
+    if (!node || b->failed) {
+        return;
+    }
+    Cfg* cfg = b->cfg;
+    switch (node->type) {
+        case AST_PROGRAM:
+        case AST_BLOCK:
+            for (int i = 0; i < node->child_count && !b->failed; i++) {
+                build_statement(b, node->children[i]);
+            }
+            break;
+        case AST_IF: {
+            int test = branch_into_new(b, node->left);
+            if (test == CFG_NONE) return;
+            build_statement(b, node->right);
+            int then_end = b->current;
+            int else_end = test;
+            if (node->else_branch) {
+                int else_entry = new_block(b);
+                if (else_entry == CFG_NONE) return;
+                cfg->blocks[test].successors[1] = else_entry;
+                b->current = else_entry;
+                build_statement(b, node->else_branch);
+                else_end = b->current;
+            }
+            int join = new_block(b);
+            if (join == CFG_NONE) return;
+            cfg->blocks[then_end].successors[0] = join;
+            cfg->blocks[else_end].successors[else_end == test] = join;
+            b->current = join;
+            break;
+        }
+        case AST_WHILE: {
+            // Header block holding only the condition; the body loops back to it.
+            if (branch_into_new(b, NULL) == CFG_NONE) return;
+            int head = branch_into_new(b, node->left);
+            if (head == CFG_NONE) return;
+            build_statement(b, node->right);
+            cfg->blocks[b->current].successors[0] = head;
+            int exit = new_block(b);
+            if (exit == CFG_NONE) return;
+            cfg->blocks[head].successors[1] = exit;
+            b->current = exit;
+            break;
+        }
+        case AST_REPEAT: {
+            // The body's last block tests the condition: true leaves, false loops.
+            if (branch_into_new(b, NULL) == CFG_NONE) return;
+            int body = b->current;
+            build_statement(b, node->left);
+            int end = branch_into_new(b, node->right);
+            if (end == CFG_NONE) return;
+            cfg->blocks[end].successors[1] = body;
+            break;
+        }
+        default:
+            append_statement(b, node);
+            break;
+    }
+}
+
+typedef struct {
+    int slot_count;
+    int in_range;             // No slot seen so far is out of range
+} RangeCheck;
+
+static AstWalkAction check_slot(const AstVisit* visit, void* context) {
+    RangeCheck* check = context;
+    if (visit->node->slot >= check->slot_count) {
+        check->in_range = 0;
+        return AST_WALK_STOP;
+    }
+    return AST_WALK_CONTINUE;
+}
+
+// 1 if every slot in the tree is below slot_count.
+static int slots_in_range(ASTNode* node, int slot_count) {
+    RangeCheck check = {slot_count, 1};
+    AstVisitor visitor = {check_slot, NULL, &check};
+    return ast_walk(node, &visitor, 1) && check.in_range;
+}
+
+void cfg_add_reads(const ASTNode* node, CfgWord* set) {
+    if (!node) {
+        return;
+    }
+    if (node->type == AST_IDENTIFIER && node->slot >= 0) {
+        cfg_set(set, node->slot);
+    }
+    cfg_add_reads(node->left, set);
+    cfg_add_reads(node->right, set);
+}
+
+// -----------------------------------------------------------------
+// Dataflow
+// -----------------------------------------------------------------
+
+typedef struct {
+    CfgWord* use;             // Read before any write in the block
+    CfgWord* def;             // Written in the block
+} Summary;
+
+// Compute a block's summary sets from its statements: the condition runs
+// last, so walk it first and then the statements in reverse.
+static void summarize(const Cfg* cfg, const CfgBlock* block, Summary* s) {
+    cfg_add_reads(block->condition, s->use);
+    for (int i = block->count - 1; i >= 0; i--) {
+        const ASTNode* node = cfg->statements[block->first + i];
+        int written = -1;
+        if (node->type == AST_VARDECL) {
+            written = node->slot;
+        } else if (node->type == AST_ASSIGN && node->left) {
+            written = node->left->slot;
+        }
+        if (written >= 0) {
+            cfg_set(s->def, written);
+            cfg_clear(s->use, written);
+        }
+        cfg_add_reads(node->type == AST_ASSIGN ? node->right : node->type == AST_VARDECL ? NULL : node,
+                      s->use);
+    }
+}
+
+// Liveness: grow from nothing, visiting blocks last to first.
+static void solve(Cfg* cfg, const Summary* summary) {
+    int words = cfg->words;
+    int count = cfg->block_count;
+    for (int changed = 1; changed;) {
+        changed = 0;
+        for (int b = count - 1; b >= 0; b--) {
+            CfgBlock* block = &cfg->blocks[b];
+            for (int e = 0; e < 2; e++) {
+                int to = block->successors[e];
+                if (to == CFG_NONE) continue;
+                const CfgWord* out = cfg->blocks[to].live_out;
+                for (int w = 0; w < words; w++) {
+                    CfgWord in = summary[to].use[w] | (out[w] & ~summary[to].def[w]);
+                    if (in & ~block->live_out[w]) {
+                        block->live_out[w] |= in;
+                        changed = 1;
+                    }
+                }
+            }
+        }
+    }
+}
+
+int cfg_build(ASTNode* program, int slot_count, Cfg* cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    if (slot_count < 0 || !slots_in_range(program, slot_count)) {
+        return 0;
+    }
+    cfg->slot_count = slot_count;
+    cfg->words = (slot_count + 63) / 64;
+    Builder builder = {cfg, 0, 0};
+    if (new_block(&builder) == CFG_NONE) {
+        return 0;
+    }
+    build_statement(&builder, program);
+    long long total = (long long)cfg->block_count * cfg->words * (SETS_KEPT + SETS_SCRATCH);
+    if (builder.failed || total > CFG_MAX_WORDS) {
+        cfg_free(cfg);
+        return 0;
+    }
+
+    size_t set_bytes = (size_t)cfg->words * sizeof(CfgWord);
+    cfg->bits = calloc((size_t)cfg->block_count * SETS_KEPT, set_bytes ? set_bytes : 1);
+    CfgWord* scratch = calloc((size_t)cfg->block_count * SETS_SCRATCH, set_bytes ? set_bytes : 1);
+    Summary* summary = malloc((size_t)cfg->block_count * sizeof(Summary));
+    if (!cfg->bits || !scratch || !summary) {
+        free(scratch);
+        free(summary);
+        cfg_free(cfg);
+        return 0;
+    }
+    for (int b = 0; b < cfg->block_count; b++) {
+        cfg->blocks[b].live_out = cfg->bits + (size_t)b * SETS_KEPT * cfg->words;
+        CfgWord* sets = scratch + (size_t)b * SETS_SCRATCH * cfg->words;
+        summary[b].use = sets;
+        summary[b].def = sets + cfg->words;
+        summarize(cfg, &cfg->blocks[b], &summary[b]);
+    }
+    solve(cfg, summary);
+    free(scratch);
+    free(summary);
+    return 1;
+}
+
+void cfg_free(Cfg* cfg) {
+    free(cfg->blocks);
+    free(cfg->statements);
+    free(cfg->bits);
+    memset(cfg, 0, sizeof(*cfg));
+}
@@ -0,0 +1,348 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/optimizer.h"
+#include "../../include/cfg.h"
+#include "../../include/stats.h"
+#include "../../include/interpreter.h"
+
+// -----------------------------------------------------------------
+// Constant folding and algebraic simplification. Expressions are
+// folded bottom-up; a node that becomes constant is rewritten in place
+// into an AST_NUMBER, and an identity such as x+0 is replaced by its
+// operand. Statement lists are walked iteratively.
+// -----------------------------------------------------------------
+
+// factorial() arguments above this stay a run-time call (the loop would
+// run at compile time even in code that never executes).
+#define FOLD_FACTORIAL_LIMIT 1000
+
+// Rounds of dead-store removal. A removed store can make the stores
+// feeding it dead in other blocks, found by the next round's liveness.
+#define DEAD_STORE_ROUNDS 4
+
+typedef struct {
+    InternTable* strings;
+    FoldStats stats;
+} Folder;
+
+static ASTNode* fold_statement(Folder* f, ASTNode* node);
+
+// Read the value of a literal node.
+static int constant_value(const ASTNode* node, Value* value) {
+    if (!node || node->type != AST_NUMBER) {
+        return 0;
+    }
+    *value = node->token.value;
+    return 1;
+}
+
+// Rewrite `node` into a literal holding `value`. Returns 0 (leaving the
+// node untouched) if the new lexeme cannot be interned.
+static int make_number(Folder* f, ASTNode* node, Value value) {
+    char text[32];
+    int length = snprintf(text, sizeof(text), "%lld", value);
+    unsigned int id = intern(f->strings, text, (size_t)length);
+    if (id == (unsigned int)-1) {
+        return 0;
+    }
+    node->type = AST_NUMBER;
+    node->token.type = TOKEN_NUMBER;
+    node->token.id = id;
+    node->token.lexeme = intern_string(f->strings, id);
+    node->token.value = value;
+    f->strings->entries[id].value = value;  // Later lexes of the same text read it
+    node->left = NULL;
+    node->right = NULL;
+    node->else_branch = NULL;
+    node->slot = -1;
+    node->depth = -1;
+    return 1;
+}
+
+// 1 if evaluating the expression could raise a runtime error and so must
+// not be removed (only division can fail).
+static int can_trap(const ASTNode* node) {
+    if (!node) {
+        return 0;
+    }
+    if (node->type == AST_BINOP && node->token.id == LEXEME_SLASH) {
+        Value divisor;
+        if (!constant_value(node->right, &divisor) || divisor == 0) {
+            return 1;
+        }
+    }
+    return can_trap(node->left) || can_trap(node->right);
+}
+
+// Compute a binary operator on two constants. Returns 0 if it must stay a
+// run-time operation (division by zero, unknown operator).
+static int evaluate_binary(unsigned int op, Value a, Value b, Value* result) {
+    switch (op) {
+        case LEXEME_PLUS:  *result = value_add(a, b); return 1;
+        case LEXEME_MINUS: *result = value_sub(a, b); return 1;
+        case LEXEME_STAR:  *result = value_mul(a, b); return 1;
+        case LEXEME_SLASH:
+            if (b == 0) {
+                return 0;
+            }
+            *result = value_div(a, b);
+            return 1;
+        case LEXEME_LT:    *result = a < b; return 1;
+        case LEXEME_GT:    *result = a > b; return 1;
+        case LEXEME_LE:    *result = a <= b; return 1;
+        case LEXEME_GE:    *result = a >= b; return 1;
+        case LEXEME_EQ:    *result = a == b; return 1;
+        case LEXEME_NE:    *result = a != b; return 1;
+        default:           return 0;
+    }
+}
+
+// Apply x+0, 0+x, x-0, x*1, 1*x, x/1, x*0 and 0*x. Returns the replacement
+// node, or NULL if no identity applies.
+static ASTNode* simplify_binary(Folder* f, ASTNode* node) {
+    Value a = 0, b = 0;
+    int left_const = constant_value(node->left, &a);
+    int right_const = constant_value(node->right, &b);
+    switch (node->token.id) {
+        case LEXEME_PLUS:
+            if (left_const && a == 0) return node->right;
+            if (right_const && b == 0) return node->left;
+            break;
+        case LEXEME_MINUS:
+            if (right_const && b == 0) return node->left;
+            break;
+        case LEXEME_STAR:
+            if (left_const && a == 1) return node->right;
+            if (right_const && b == 1) return node->left;
+            if ((left_const && a == 0 && !can_trap(node->right)) ||
+                (right_const && b == 0 && !can_trap(node->left))) {
+                return make_number(f, node, 0) ? node : NULL;
+            }
+            break;
+        case LEXEME_SLASH:
+            if (right_const && b == 1) return node->left;
+            break;
+        default:
+            break;
+    }
+    return NULL;
+}
+
+// Fold an expression; returns the node that should replace it.
+static ASTNode* fold_expression(Folder* f, ASTNode* node) {
+    if (!node) {
+        return NULL;
+    }
+    Value a, b, result;
+    switch (node->type) {
+        case AST_BINOP: {
+            node->left = fold_expression(f, node->left);
+            node->right = fold_expression(f, node->right);
+            if (constant_value(node->left, &a) && constant_value(node->right, &b)) {
+                if (evaluate_binary(node->token.id, a, b, &result) && make_number(f, node, result)) {
+                    f->stats.folded++;
+                }
+                return node;
+            }
+            ASTNode* simpler = simplify_binary(f, node);
+            if (simpler) {
+                f->stats.simplified++;
+                return simpler;
+            }
+            return node;
+        }
+        case AST_FUNCALL:
+            node->left = fold_expression(f, node->left);
+            if (constant_value(node->left, &a) && a <= FOLD_FACTORIAL_LIMIT &&
+                make_number(f, node, value_factorial(a))) {
+                f->stats.folded++;
+            }
+            return node;
+        default:
+            return node;
+    }
+}
+
+// Fold every statement of an AST_PROGRAM or AST_BLOCK, dropping the ones
+// that fold away.
+static void fold_children(Folder* f, ASTNode* node) {
+    int kept = 0;
+    for (int i = 0; i < node->child_count; i++) {
+        ASTNode* statement = fold_statement(f, node->children[i]);
+        if (statement) {
+            node->children[kept++] = statement;
+        }
+    }
+    node->child_count = kept;
+}
+
+// Fold one statement; returns its replacement (NULL = no statement).
+static ASTNode* fold_statement(Folder* f, ASTNode* node) {
+    if (!node) {
+        return NULL;
+    }
+    Value condition;
+    switch (node->type) {
+        case AST_PROGRAM:
+        case AST_BLOCK:
+            fold_children(f, node);
+            return node;
+        case AST_VARDECL:
+            return node;
+        case AST_ASSIGN:
+            node->right = fold_expression(f, node->right);
+            return node;
+        case AST_PRINT:
+            node->left = fold_expression(f, node->left);
+            return node;
+        case AST_IF:
+            node->left = fold_expression(f, node->left);
+            node->right = fold_statement(f, node->right);
+            node->else_branch = fold_statement(f, node->else_branch);
+            if (constant_value(node->left, &condition)) {
+                f->stats.pruned++;
+                return condition ? node->right : node->else_branch;
+            }
+            return node;
+        case AST_WHILE:
+            node->left = fold_expression(f, node->left);
+            node->right = fold_statement(f, node->right);
+            if (constant_value(node->left, &condition) && !condition) {
+                f->stats.pruned++;
+                return NULL;  // Body never runs
+            }
+            return node;
+        case AST_REPEAT:
+            node->left = fold_statement(f, node->left);
+            node->right = fold_expression(f, node->right);
+            if (constant_value(node->right, &condition) && condition) {
+                f->stats.pruned++;
+                return node->left;  // Body runs exactly once
+            }
+            return node;
+        default:
+            return fold_expression(f, node);
+    }
+}
+
+// -----------------------------------------------------------------
+// Dead-store elimination
+// -----------------------------------------------------------------
+
+static int compare_nodes(const void* a, const void* b) {
+    uintptr_t x = (uintptr_t)*(ASTNode* const*)a;
+    uintptr_t y = (uintptr_t)*(ASTNode* const*)b;
+    return x < y ? -1 : x > y;
+}
+
+// 1 if `node` is in the sorted array of dead statements.
+static int is_dead(ASTNode* node, ASTNode** dead, int count) {
+    return node && bsearch(&node, dead, (size_t)count, sizeof(ASTNode*), compare_nodes) != NULL;
+}
+
+// Unlink the dead statements from their program, block or parent statement.
+static void remove_statements(ASTNode* node, ASTNode** dead, int count) {
+    if (!node) {
+        return;
+    }
+    switch (node->type) {
+        case AST_PROGRAM:
+        case AST_BLOCK: {
+            int kept = 0;
+            for (int i = 0; i < node->child_count; i++) {
+                ASTNode* statement = node->children[i];
+                if (!is_dead(statement, dead, count)) {
+                    remove_statements(statement, dead, count);
+                    node->children[kept++] = statement;
+                }
+            }
+            node->child_count = kept;
+            break;
+        }
+        case AST_IF:
+            if (is_dead(node->right, dead, count)) node->right = NULL;
+            if (is_dead(node->else_branch, dead, count)) node->else_branch = NULL;
+            remove_statements(node->right, dead, count);
+            remove_statements(node->else_branch, dead, count);
+            break;
+        case AST_WHILE:
+            if (is_dead(node->right, dead, count)) node->right = NULL;
+            remove_statements(node->right, dead, count);
+            break;
+        case AST_REPEAT:
+            if (is_dead(node->left, dead, count)) node->left = NULL;
+            remove_statements(node->left, dead, count);
+            break;
+        default:
+            break;
+    }
+}
+
+// Collect the statements of each block that store a value no later read
+// can see: walk the block backwards from its live_out set. The reads of
+// a dead store are not counted, so a chain of them dies in one pass.
+// Declarations stay even when nothing reads the variable: the tree must
+// still pass the checker, and every later use needs its declaration.
+static int find_dead_stores(const Cfg* cfg, CfgWord* live, ASTNode** dead) {
+    int count = 0;
+    for (int b = 0; b < cfg->block_count; b++) {
+        const CfgBlock* block = &cfg->blocks[b];
+        memcpy(live, block->live_out, (size_t)cfg->words * sizeof(CfgWord));
+        cfg_add_reads(block->condition, live);
+        for (int i = block->count - 1; i >= 0; i--) {
+            ASTNode* node = cfg->statements[block->first + i];
+            if (node->type == AST_VARDECL && node->slot >= 0) {
+                cfg_clear(live, node->slot);
+            } else if (node->type == AST_ASSIGN && node->left && node->left->slot >= 0) {
+                if (!cfg_test(live, node->left->slot) && !can_trap(node->right)) {
+                    dead[count++] = node;
+                    continue;
+                }
+                cfg_clear(live, node->left->slot);
+                cfg_add_reads(node->right, live);
+            } else {
+                cfg_add_reads(node, live);
+            }
+        }
+    }
+    return count;
+}
+
+static void eliminate_dead_stores(Folder* f, ASTNode* program) {
+    for (int round = 0; round < DEAD_STORE_ROUNDS; round++) {
+        Cfg cfg;
+        if (!cfg_build(program, program->frame_size, &cfg)) {
+            return;
+        }
+        CfgWord* live = malloc(((size_t)cfg.words + 1) * sizeof(CfgWord));
+        ASTNode** dead = malloc(((size_t)cfg.statement_count + 1) * sizeof(ASTNode*));
+        int count = live && dead ? find_dead_stores(&cfg, live, dead) : 0;
+        if (count > 0) {
+            qsort(dead, (size_t)count, sizeof(ASTNode*), compare_nodes);
+            remove_statements(program, dead, count);
+            f->stats.dead_stores += count;
+        }
+        free(live);
+        free(dead);
+        cfg_free(&cfg);
+        if (count == 0) {
+            return;
+        }
+    }
+}
+
+void fold_constants(ASTNode* program, InternTable* strings, FoldStats* stats) {
+    Folder folder;
+    folder.strings = strings;
+    memset(&folder.stats, 0, sizeof(folder.stats));
+    STATS_START(timer);
+    fold_statement(&folder, program);
+    if (program && program->type == AST_PROGRAM && program->frame_size > 0) {
+        eliminate_dead_stores(&folder, program);
+    }
+    STATS_STOP(STATS_FOLD, timer);
+    if (stats) {
+        *stats = folder.stats;
+    }
+}
@@ -0,0 +1,148 @@
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/ast_visit.h"
+
+// -----------------------------------------------------------------
+// Iterative walk. Each frame on the stack is a node whose children are
+// still being visited; `next` counts through its statement list and then
+// its left, right and else_branch fields, skipping the ones its kind does
+// not use and the empty ones.
+// -----------------------------------------------------------------
+
+#define WALK_LOCAL_FRAMES 64
+#define ALL_CHILDREN (AST_CHILD_LIST | AST_CHILD_LEFT | AST_CHILD_RIGHT | AST_CHILD_ELSE)
+
+typedef struct {
+    AstVisit visit;
+    unsigned int entered;     // Visitors whose leave is due
+    unsigned int descend;     // Visitors shown the children
+    int next;                 // Next child position
+} Frame;
+
+typedef struct {
+    const AstVisitor* visitors;
+    int count;
+    unsigned int alive;       // Visitors that have not stopped
+    Frame* stack;
+    int top;
+    int capacity;
+    Frame local[WALK_LOCAL_FRAMES];
+} Walk;
+
+static unsigned int kind_children(const ASTNode* node) {
+    return (unsigned int)node->type < AST_KIND_COUNT ? ast_kinds[node->type].children : ALL_CHILDREN;
+}
+
+// Push `node` and show it to the visitors in `shown`; returns 0 on out-of-memory.
+static int push(Walk* w, ASTNode* node, ASTNode* parent, AstField field, int index, int depth,
+                unsigned int shown) {
+    if (w->top == w->capacity) {
+        int capacity = w->capacity * 2;
+        Frame* stack;
+        if (w->stack == w->local) {
+            stack = malloc((size_t)capacity * sizeof(Frame));
+            if (stack) memcpy(stack, w->local, sizeof(w->local));
+        } else {
+            stack = realloc(w->stack, (size_t)capacity * sizeof(Frame));
+        }
+        if (!stack) {
+            return 0;
+        }
+        w->stack = stack;
+        w->capacity = capacity;
+    }
+    Frame* frame = &w->stack[w->top++];
+    frame->visit.node = node;
+    frame->visit.parent = parent;
+    frame->visit.field = field;
+    frame->visit.index = index;
+    frame->visit.depth = depth;
+    frame->entered = 0;
+    frame->descend = 0;
+    frame->next = 0;
+    for (int i = 0; i < w->count; i++) {
+        unsigned int bit = 1u << i;
+        if (!(shown & bit)) continue;
+        const AstVisitor* visitor = &w->visitors[i];
+        AstWalkAction action = visitor->enter ? visitor->enter(&frame->visit, visitor->context)
+                                              : AST_WALK_CONTINUE;
+        if (action == AST_WALK_STOP) {
+            w->alive &= ~bit;
+            continue;
+        }
+        frame->entered |= bit;
+        if (action == AST_WALK_CONTINUE) {
+            frame->descend |= bit;
+        }
+    }
+    return 1;
+}
+
+// Next non-empty child of the frame's node, or NULL once there are none.
+static ASTNode* next_child(Frame* frame, AstField* field, int* index) {
+    ASTNode* node = frame->visit.node;
+    unsigned int children = kind_children(node);
+    int list = (children & AST_CHILD_LIST) ? node->child_count : 0;
+    while (frame->next < list + 3) {
+        int position = frame->next++;
+        ASTNode* child;
+        if (position < list) {
+            child = node->children[position];
+            *field = AST_FIELD_LIST;
+            *index = position;
+        } else if (position == list) {
+            child = (children & AST_CHILD_LEFT) ? node->left : NULL;
+            *field = AST_FIELD_LEFT;
+        } else if (position == list + 1) {
+            child = (children & AST_CHILD_RIGHT) ? node->right : NULL;
+            *field = AST_FIELD_RIGHT;
+        } else {
+            child = (children & AST_CHILD_ELSE) ? node->else_branch : NULL;
+            *field = AST_FIELD_ELSE;
+        }
+        if (child) {
+            return child;
+        }
+    }
+    return NULL;
+}
+
+int ast_walk(ASTNode* root, const AstVisitor* visitors, int count) {
+    if (!root || count <= 0) {
+        return 1;
+    }
+    if (count > AST_MAX_VISITORS) {
+        count = AST_MAX_VISITORS;
+    }
+    Walk w;
+    w.visitors = visitors;
+    w.count = count;
+    w.alive = (1u << count) - 1;
+    w.stack = w.local;
+    w.top = 0;
+    w.capacity = WALK_LOCAL_FRAMES;
+
+    int ok = push(&w, root, NULL, AST_FIELD_ROOT, 0, 0, w.alive);
+    while (ok && w.top > 0 && w.alive) {
+        Frame* frame = &w.stack[w.top - 1];
+        unsigned int descend = frame->descend & w.alive;
+        AstField field = AST_FIELD_ROOT;
+        int index = 0;
+        ASTNode* child = descend ? next_child(frame, &field, &index) : NULL;
+        if (child) {
+            ok = push(&w, child, frame->visit.node, field, index, frame->visit.depth + 1, descend);
+            continue;
+        }
+        unsigned int due = frame->entered & w.alive;
+        for (int i = 0; i < count; i++) {
+            if ((due & (1u << i)) && visitors[i].leave) {
+                visitors[i].leave(&frame->visit, visitors[i].context);
+            }
+        }
+        w.top--;
+    }
+    if (w.stack != w.local) {
+        free(w.stack);
+    }
+    return ok;
+}
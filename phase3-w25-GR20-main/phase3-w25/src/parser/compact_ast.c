@@ -0,0 +1,150 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/compact_ast.h"
+
+// -----------------------------------------------------------------
+// Conversion from the pointer tree and preorder sweeps. Conversion
+// recurses into children (AST height is bounded by the parser) and walks
+// statement lists in a loop.
+// -----------------------------------------------------------------
+
+static int is_list(uint8_t kind) {
+    return kind < AST_KIND_COUNT && (ast_kinds[kind].children & AST_CHILD_LIST);
+}
+
+static int grow(CompactAst *ast) {
+    uint32_t capacity = ast->capacity ? ast->capacity * 2 : 256;
+    uint8_t *kind = realloc(ast->kind, capacity * sizeof(*ast->kind));
+    if (kind) ast->kind = kind;
+    uint32_t *lexeme = realloc(ast->lexeme, capacity * sizeof(*ast->lexeme));
+    if (lexeme) ast->lexeme = lexeme;
+    int32_t *line = realloc(ast->line, capacity * sizeof(*ast->line));
+    if (line) ast->line = line;
+    int32_t *slot = realloc(ast->slot, capacity * sizeof(*ast->slot));
+    if (slot) ast->slot = slot;
+    uint32_t *first_child = realloc(ast->first_child, capacity * sizeof(*ast->first_child));
+    if (first_child) ast->first_child = first_child;
+    uint32_t *next_sibling = realloc(ast->next_sibling, capacity * sizeof(*ast->next_sibling));
+    if (next_sibling) ast->next_sibling = next_sibling;
+    if (!kind || !lexeme || !line || !slot || !first_child || !next_sibling) {
+        return 0;
+    }
+    ast->capacity = capacity;
+    return 1;
+}
+
+// Append one node (a placeholder if `node` is NULL); returns its index.
+static uint32_t append(CompactAst *ast, const ASTNode *node) {
+    if (ast->count == ast->capacity && !grow(ast)) {
+        return COMPACT_NONE;
+    }
+    uint32_t index = ast->count++;
+    ast->kind[index] = node ? (uint8_t)node->type : COMPACT_EMPTY;
+    ast->lexeme[index] = node ? node->token.id : 0;
+    ast->line[index] = node ? node->token.line : 0;
+    ast->slot[index] = node ? node->slot : -1;
+    ast->first_child[index] = COMPACT_NONE;
+    ast->next_sibling[index] = COMPACT_NONE;
+    return index;
+}
+
+// Convert `node` and its subtree; returns its index or COMPACT_NONE.
+static uint32_t convert(CompactAst *ast, const ASTNode *node) {
+    uint32_t index = append(ast, node);
+    if (index == COMPACT_NONE || !node) {
+        return index;
+    }
+    const ASTNode *fixed[3] = {node->left, node->right, node->else_branch};
+    int fixed_count = 3;
+    while (fixed_count > 0 && !fixed[fixed_count - 1]) {
+        fixed_count--;  // Trailing missing children need no placeholder
+    }
+    uint32_t previous = COMPACT_NONE;
+    for (int i = 0; i < node->child_count + fixed_count; i++) {
+        const ASTNode *child = i < node->child_count ? node->children[i]
+                                                     : fixed[i - node->child_count];
+        uint32_t converted = convert(ast, child);
+        if (converted == COMPACT_NONE) {
+            return COMPACT_NONE;
+        }
+        if (previous == COMPACT_NONE) {
+            ast->first_child[index] = converted;
+        } else {
+            ast->next_sibling[previous] = converted;
+        }
+        previous = converted;
+    }
+    return index;
+}
+
+int compact_ast_from_tree(const ASTNode *root, CompactAst *ast) {
+    memset(ast, 0, sizeof(*ast));
+    if (root && convert(ast, root) == COMPACT_NONE) {
+        compact_ast_free(ast);
+        return 0;
+    }
+    return 1;
+}
+
+void compact_ast_free(CompactAst *ast) {
+    free(ast->kind);
+    free(ast->lexeme);
+    free(ast->line);
+    free(ast->slot);
+    free(ast->first_child);
+    free(ast->next_sibling);
+    memset(ast, 0, sizeof(*ast));
+}
+
+uint32_t compact_ast_subtree_end(const CompactAst *ast, uint32_t node) {
+    for (;;) {
+        uint32_t child = ast->first_child[node];
+        if (child == COMPACT_NONE) {
+            return node + 1;
+        }
+        while (ast->next_sibling[child] != COMPACT_NONE) {
+            child = ast->next_sibling[child];
+        }
+        node = child;  // The last child's subtree ends the parent's
+    }
+}
+
+// One sweep in storage order: each node's indentation is assigned by its
+// parent, which always comes first.
+int compact_ast_print(const CompactAst *ast, const InternTable *strings, FILE *out) {
+    if (ast->count == 0) {
+        return 1;
+    }
+    int32_t *level = malloc(ast->count * sizeof(int32_t));
+    uint8_t *is_else = calloc(ast->count, 1);
+    if (!level || !is_else) {
+        free(level);
+        free(is_else);
+        return 0;
+    }
+    level[0] = 0;
+    for (uint32_t i = 0; i < ast->count; i++) {
+        uint8_t kind = ast->kind[i];
+        if (kind == COMPACT_EMPTY) {
+            continue;  // Placeholders have no children
+        }
+        if (is_else[i]) {
+            for (int k = 0; k < level[i] - 1; k++) fputs("  ", out);
+            fputs("Else:\n", out);
+        }
+        for (int k = 0; k < level[i]; k++) fputs("  ", out);
+        print_ast_label(out, (ASTNodeType)kind, intern_string(strings, ast->lexeme[i]));
+
+        int position = 0;
+        for (uint32_t c = ast->first_child[i]; c != COMPACT_NONE; c = ast->next_sibling[c]) {
+            int else_arm = !is_list(kind) && position == 2;
+            level[c] = level[i] + 1 + else_arm;
+            is_else[c] = (uint8_t)else_arm;
+            position++;
+        }
+    }
+    free(level);
+    free(is_else);
+    return 1;
+}
@@ -2,115 +2,115 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <setjmp.h>
 #include "../../include/parser.h"
 #include "../../include/lexer.h"
 #include "../../include/tokens.h"
+#include "../../include/arena.h"
+#include "../../include/stats.h"
+#include "../../include/ast_visit.h"
 
 // -----------------------------------------------------------------
 // Forward Declarations for New Statement Types
 // -----------------------------------------------------------------
-static ASTNode* parse_if_statement(void);
-static ASTNode* parse_while_statement(void);
-static ASTNode* parse_repeat_statement(void);
-static ASTNode* parse_print_statement(void);
-static ASTNode* parse_block(void);
-static ASTNode* parse_factorial(void);
+static ASTNode* parse_if_statement(Parser *p);
+static ASTNode* parse_while_statement(Parser *p);
+static ASTNode* parse_repeat_statement(Parser *p);
+static ASTNode* parse_print_statement(Parser *p);
+static ASTNode* parse_block(Parser *p);
 
 // -----------------------------------------------------------------
 // Forward Declarations for Expression and Statement Parsing
 // -----------------------------------------------------------------
-static ASTNode *parse_expression(void);
-static ASTNode *parse_statement(void);
+static ASTNode *parse_expression(Parser *p);
+static ASTNode *parse_statement(Parser *p);
+static void parse_statement_list(Parser *p, ASTNode *head, TokenType end);
 
 // -----------------------------------------------------------------
-// Global Variables for Parser State
+// Default Parser Context (backs the global parser_init/parse API)
 // -----------------------------------------------------------------
-static Token current_token;
-static int position = 0;
-static const char *source;
+static Parser default_parser;
 
 // -----------------------------------------------------------------
 // Extended Parse Error Reporting
 // -----------------------------------------------------------------
-static void dbg() {
-    printf("%d - %d - %s\n", current_token.line, current_token.type, current_token.lexeme);
+static void dbg(Parser *p) {
+    printf("%d - %d - %s\n", p->current.line, p->current.type, p->current.lexeme);
 }
 
-static void parse_error(ParseError error, Token token) {
-    printf("Parse Error at line %d: ", token.line);
-    switch (error) {
-        case PARSE_ERROR_UNEXPECTED_TOKEN:
-            printf("Unexpected token '%s'\n", token.lexeme);
-            break;
-        case PARSE_ERROR_MISSING_SEMICOLON:
-            printf("Missing semicolon after '%s'\n", token.lexeme);
-            break;
-        case PARSE_ERROR_MISSING_IDENTIFIER:
-            printf("Expected identifier after '%s'\n", token.lexeme);
-            break;
-        case PARSE_ERROR_MISSING_EQUALS:
-            printf("Expected '=' after '%s'\n", token.lexeme);
-            break;
-        case PARSE_ERROR_INVALID_EXPRESSION:
-            printf("Invalid expression after '%s'\n", token.lexeme);
-            break;
-        case PARSE_ERROR_MISSING_LPAREN:
-            printf("Missing '(' after '%s'\n", token.lexeme);
-            break;
-        case PARSE_ERROR_MISSING_RPAREN:
-            printf("Missing ')' after '%s'\n", token.lexeme);
-            break;
-        case PARSE_ERROR_MISSING_CONDITION:
-            printf("Missing condition after '%s'\n", token.lexeme);
-            break;
-        case PARSE_ERROR_MISSING_BLOCK:
-            printf("Missing block braces after '%s'\n", token.lexeme);
-            break;
-        case PARSE_ERROR_INVALID_OPERATOR:
-            printf("Invalid operator '%s'\n", token.lexeme);
-            break;
-        case PARSE_ERROR_FUNCTION_CALL:
-            printf("Function call error near '%s'\n", token.lexeme);
-            break;
-        default:
-            printf("Unknown error\n");
-    }
+// Record a syntax error at `token`.
+static void parse_error(Parser *p, ParseError error, Token token) {
+    diagnostics_add(&p->diagnostics, DIAGNOSTIC_SYNTAX, error, token.line, token.column, token.lexeme);
+}
+
+// Abandon the current statement after an error has been reported: control
+// returns to parse_statement_recovering, which resynchronizes.
+_Noreturn static void abort_parse(Parser *p) {
+    longjmp(p->on_error, 1);
 }
 
 // -----------------------------------------------------------------
 // Basic Parser Utilities
 // -----------------------------------------------------------------
 
-// Consume the current token and move to the next one.
-static void advance(void) {
-    current_token = get_next_token(source, &position);
+// Token `index` of the stream; indices past the end yield the EOF token.
+// A ring only ever gets asked for the token after EOF by peek at EOF.
+static Token fetch(Parser *p, int index) {
+    if (!p->ring) {
+        return token_at(p->tokens, index);
+    }
+    const Token *token = spsc_ring_get(p->ring, (size_t)index);
+    return token ? *token : p->current;
+}
+
+// Consume the current token and move to the next one. Tokens behind the
+// current one are never read again, so a ring may reuse their slots.
+static void advance(Parser *p) {
+    if (p->ring ? p->current.type != TOKEN_EOF : p->token_index < p->tokens->count - 1) {
+        p->token_index++;
+    }
+    p->current = fetch(p, p->token_index);
+    if (p->ring) {
+        spsc_ring_release(p->ring, (size_t)p->token_index);
+    }
 }
 
-// Create a new AST node.
-static ASTNode *create_node(ASTNodeType type) {
-    ASTNode *node = malloc(sizeof(ASTNode));
+// Look k tokens past the current one without consuming anything.
+static Token peek(Parser *p, int k) {
+    return fetch(p, p->token_index + k);
+}
+
+// Create a new AST node (allocated from the parser arena).
+static ASTNode *create_node(Parser *p, ASTNodeType type) {
+    ASTNode *node = arena_alloc(&p->arena, sizeof(ASTNode));
+    STATS_COUNT(nodes, 1);
     if (node) {
         node->type = type;
-        node->token = current_token;
+        node->token = p->current;
         node->left = NULL;
         node->right = NULL;
         node->else_branch = NULL;
+        node->children = NULL;
+        node->child_count = 0;
+        node->slot = -1;
+        node->depth = -1;
+        node->frame_size = 0;
     }
     return node;
 }
 
 // Check if the current token matches the expected type.
-static int match(TokenType type) {
-    return current_token.type == type;
+static int match(Parser *p, TokenType type) {
+    return p->current.type == type;
 }
 
 // Expect a token of a given type or report an error.
-static void expect(TokenType type) {
-    if (match(type)) {
-        advance();
+static void expect(Parser *p, TokenType type) {
+    if (match(p, type)) {
+        advance(p);
     } else {
-        parse_error(PARSE_ERROR_UNEXPECTED_TOKEN, current_token);
-        exit(1); // Could implement error recovery instead.
+        parse_error(p, PARSE_ERROR_UNEXPECTED_TOKEN, p->current);
+        abort_parse(p);
     }
 }
 
@@ -118,113 +118,155 @@ static void expect(TokenType type) {
 // Expression Parsing with Operator Precedence
 // -----------------------------------------------------------------
 
-// Forward declarations for expression helper functions.
-static ASTNode *parse_primary(void);
-static ASTNode *parse_factor(void);
-static ASTNode *parse_term(void);
-static ASTNode *parse_comparison(void);
-static ASTNode *parse_equality(void);
-
-// parse_primary: Handles numbers, identifiers (or function calls), and parenthesized expressions.
-static ASTNode *parse_primary(void) {
+// The expression grammar (loosest first: == !=, < >, + -, * /, all left
+// associative) is parsed by operator precedence with explicit stacks
+// instead of one recursive function per level, so C stack use does not
+// grow with the length or nesting of an expression. Pending binary
+// operators between two open parentheses always have strictly increasing
+// precedence, so at most four of them wait per nesting level.
+#define EXPR_STACK_SIZE (5 * (PARSER_MAX_NESTING + 1))
+
+typedef enum {
+    PENDING_BINARY,           // Binary operator waiting for its right operand
+    PENDING_PAREN,            // '(' of a parenthesized expression
+    PENDING_CALL              // 'factorial(' of a call
+} PendingKind;
+
+typedef struct {
+    PendingKind kind;
+    int precedence;           // Binding power (binary operators only)
+    Token token;              // Operator, '(' or factorial token
+} PendingOperator;
+
+typedef struct {
     ASTNode *node;
-    if (match(TOKEN_NUMBER)) {
-        node = create_node(AST_NUMBER);
-        advance();
-        return node;
-    } else if (match(TOKEN_IDENTIFIER)) {
-        // Look ahead to determine if this is a function call.
-        int saved_position = position;
-        Token next_token = get_next_token(source, &position);
-        position = saved_position; // Restore position
-        if (next_token.type == TOKEN_LPAREN && strcmp(current_token.lexeme, "factorial") == 0) {
-            return parse_factorial();
-        } else {
-            node = create_node(AST_IDENTIFIER);
-            advance();
-            return node;
-        }
-    } else if (match(TOKEN_LPAREN)) {
-        advance(); // consume '('
-        node = parse_expression();
-        expect(TOKEN_RPAREN); // expect ')'
-        return node;
-    } else {
-        printf("Syntax Error: Expected primary expression at line %d\n", current_token.line);
-        exit(1);
+    int height;               // Height of the subtree rooted at node
+} Operand;
+
+typedef struct {
+    PendingOperator operators[EXPR_STACK_SIZE];
+    int operator_count;
+    Operand operands[EXPR_STACK_SIZE];
+    int operand_count;
+} ExpressionStacks;
+
+// Binding power of a binary operator token; 0 if the token is not one.
+static int binary_precedence(const Token *token) {
+    if (token->type != TOKEN_OPERATOR) {
+        return 0;
     }
-}
-
-// parse_factor: Handles multiplication and division.
-static ASTNode *parse_factor(void) {
-    ASTNode *node = parse_primary();
-    while (match(TOKEN_OPERATOR) && (current_token.lexeme[0] == '*' || current_token.lexeme[0] == '/')) {
-        Token op = current_token;
-        advance(); // consume operator
-        ASTNode *right = parse_primary();
-        ASTNode *new_node = create_node(AST_BINOP);
-        new_node->token = op;
-        new_node->left = node;
-        new_node->right = right;
-        node = new_node;
+    switch (token->id) {
+        case LEXEME_EQ: case LEXEME_NE:      return 1;
+        case LEXEME_LT: case LEXEME_GT:      return 2;
+        case LEXEME_PLUS: case LEXEME_MINUS: return 3;
+        case LEXEME_STAR: case LEXEME_SLASH: return 4;
+        default:                             return 0;
     }
-    return node;
 }
 
-// parse_term: Handles addition and subtraction.
-static ASTNode *parse_term(void) {
-    ASTNode *node = parse_factor();
-    while (match(TOKEN_OPERATOR) && (current_token.lexeme[0] == '+' || current_token.lexeme[0] == '-')) {
-        Token op = current_token;
-        advance(); // consume operator
-        ASTNode *right = parse_factor();
-        ASTNode *new_node = create_node(AST_BINOP);
-        new_node->token = op;
-        new_node->left = node;
-        new_node->right = right;
-        node = new_node;
+// Store `node`, whose tallest child has height `child_height`, in an
+// operand slot; trees taller than PARSER_MAX_EXPRESSION_DEPTH are rejected.
+static void set_operand(Parser *p, Operand *slot, ASTNode *node, int child_height) {
+    if (child_height >= PARSER_MAX_EXPRESSION_DEPTH) {
+        parse_error(p, PARSE_ERROR_NESTING_TOO_DEEP, node->token);
+        abort_parse(p);
     }
-    return node;
+    slot->node = node;
+    slot->height = child_height + 1;
 }
 
-// parse_comparison: Handles relational operators like '<' and '>'.
-static ASTNode *parse_comparison(void) {
-    ASTNode *node = parse_term();
-    while (match(TOKEN_OPERATOR) &&
-           (strcmp(current_token.lexeme, "<") == 0 || strcmp(current_token.lexeme, ">") == 0)) {
-        Token op = current_token;
-        advance(); // consume operator
-        ASTNode *right = parse_term();
-        ASTNode *new_node = create_node(AST_BINOP);
-        new_node->token = op;
-        new_node->left = node;
-        new_node->right = right;
-        node = new_node;
-    }
-    return node;
+// Pop the top binary operator and its two operands into an AST_BINOP.
+static void reduce(Parser *p, ExpressionStacks *s) {
+    PendingOperator op = s->operators[--s->operator_count];
+    Operand right = s->operands[--s->operand_count];
+    Operand *left = &s->operands[s->operand_count - 1];
+    ASTNode *node = create_node(p, AST_BINOP);
+    node->token = op.token;
+    node->left = left->node;
+    node->right = right.node;
+    set_operand(p, left, node, left->height > right.height ? left->height : right.height);
 }
 
-// parse_equality: Handles equality operators (== and !=).
-static ASTNode *parse_equality(void) {
-    ASTNode *node = parse_comparison();
-    while (match(TOKEN_OPERATOR) &&
-           (strcmp(current_token.lexeme, "==") == 0 || strcmp(current_token.lexeme, "!=") == 0)) {
-        Token op = current_token;
-        advance(); // consume operator
-        ASTNode *right = parse_comparison();
-        ASTNode *new_node = create_node(AST_BINOP);
-        new_node->token = op;
-        new_node->left = node;
-        new_node->right = right;
-        node = new_node;
-    }
-    return node;
+static void push_operator(ExpressionStacks *s, PendingKind kind, int precedence, Token token) {
+    PendingOperator *op = &s->operators[s->operator_count++];
+    op->kind = kind;
+    op->precedence = precedence;
+    op->token = token;
 }
 
-// The top-level parse_expression now uses our equality parsing.
-static ASTNode *parse_expression(void) {
-    ASTNode* node = parse_equality();
-    return node;
+// parse_expression: numbers, identifiers, factorial(...) calls and
+// parenthesized expressions joined by binary operators.
+static ASTNode *parse_expression(Parser *p) {
+    ExpressionStacks s;
+    s.operator_count = 0;
+    s.operand_count = 0;
+    int open = 0;  // Unclosed '(' and 'factorial(' on the operator stack
+    for (;;) {
+        // An operand, or an opening parenthesis or call in front of one.
+        int call = match(p, TOKEN_IDENTIFIER) && p->current.id == LEXEME_FACTORIAL &&
+                   peek(p, 1).type == TOKEN_LPAREN;
+        if (match(p, TOKEN_NUMBER) || (match(p, TOKEN_IDENTIFIER) && !call)) {
+            ASTNode *leaf = create_node(p, match(p, TOKEN_NUMBER) ? AST_NUMBER : AST_IDENTIFIER);
+            set_operand(p, &s.operands[s.operand_count++], leaf, 0);
+            advance(p);
+        } else if (call || match(p, TOKEN_LPAREN)) {
+            if (open == PARSER_MAX_NESTING) {
+                parse_error(p, PARSE_ERROR_NESTING_TOO_DEEP, p->current);
+                abort_parse(p);
+            }
+            push_operator(&s, call ? PENDING_CALL : PENDING_PAREN, 0, p->current);
+            open++;
+            advance(p); // consume 'factorial' or '('
+            if (call) {
+                expect(p, TOKEN_LPAREN);
+            }
+            continue;
+        } else if (p->current.error != ERROR_NONE) {
+            // A token the lexer rejected (a bad character, a number out of range)
+            diagnostics_add(&p->diagnostics, DIAGNOSTIC_LEXICAL, p->current.error, p->current.line,
+                            p->current.column, p->current.lexeme);
+            abort_parse(p);
+        } else {
+            parse_error(p, PARSE_ERROR_EXPECTED_PRIMARY, p->current);
+            abort_parse(p);
+        }
+
+        // Close as many parentheses and calls as follow the operand.
+        while (open > 0 && match(p, TOKEN_RPAREN)) {
+            while (s.operators[s.operator_count - 1].kind == PENDING_BINARY) {
+                reduce(p, &s);
+            }
+            PendingOperator marker = s.operators[--s.operator_count];
+            open--;
+            advance(p); // consume ')'
+            if (marker.kind == PENDING_CALL) {
+                Operand *argument = &s.operands[s.operand_count - 1];
+                ASTNode *node = create_node(p, AST_FUNCALL);
+                node->token = marker.token;
+                node->left = argument->node;
+                set_operand(p, argument, node, argument->height);
+            }
+        }
+
+        // A binary operator continues the expression; anything else ends it.
+        int precedence = binary_precedence(&p->current);
+        if (!precedence) {
+            break;
+        }
+        while (s.operator_count > 0 && s.operators[s.operator_count - 1].kind == PENDING_BINARY &&
+               s.operators[s.operator_count - 1].precedence >= precedence) {
+            reduce(p, &s);
+        }
+        push_operator(&s, PENDING_BINARY, precedence, p->current);
+        advance(p); // consume operator
+    }
+    if (open > 0) {
+        expect(p, TOKEN_RPAREN);  // Reports the token where ')' was expected
+    }
+    while (s.operator_count > 0) {
+        reduce(p, &s);
+    }
+    return s.operands[0].node;
 }
 
 // -----------------------------------------------------------------
@@ -232,318 +274,435 @@ static ASTNode *parse_expression(void) {
 // -----------------------------------------------------------------
 
 // Parse variable declaration: int x;
-static ASTNode *parse_declaration(void) {
-    ASTNode *node = create_node(AST_VARDECL);
-    advance(); // consume 'int'
-    if (!match(TOKEN_IDENTIFIER)) {
-        parse_error(PARSE_ERROR_MISSING_IDENTIFIER, current_token);
-        exit(1);
-    }
-    node->token = current_token;
-    advance();
-    if (!match(TOKEN_SEMICOLON)) {
-        parse_error(PARSE_ERROR_MISSING_SEMICOLON, current_token);
-        exit(1);
-    }
-    advance();
+static ASTNode *parse_declaration(Parser *p) {
+    ASTNode *node = create_node(p, AST_VARDECL);
+    advance(p); // consume 'int'
+    if (!match(p, TOKEN_IDENTIFIER)) {
+        parse_error(p, PARSE_ERROR_MISSING_IDENTIFIER, p->current);
+        abort_parse(p);
+    }
+    node->token = p->current;
+    advance(p);
+    if (!match(p, TOKEN_SEMICOLON)) {
+        parse_error(p, PARSE_ERROR_MISSING_SEMICOLON, p->current);
+        abort_parse(p);
+    }
+    advance(p);
     return node;
 }
 
 // Parse assignment: x = expression;
-static ASTNode *parse_assignment(void) {
-    ASTNode *node = create_node(AST_ASSIGN);
-    node->left = create_node(AST_IDENTIFIER);
-    node->left->token = current_token;
-    advance();
-    if (!match(TOKEN_EQUALS)) {
-        parse_error(PARSE_ERROR_MISSING_EQUALS, current_token);
-        exit(1);
-    }
-    advance();
-    node->right = parse_expression();
-    if (!match(TOKEN_SEMICOLON)) {
-        parse_error(PARSE_ERROR_MISSING_SEMICOLON, current_token);
-        exit(1);
-    }
-    advance();
+static ASTNode *parse_assignment(Parser *p) {
+    ASTNode *node = create_node(p, AST_ASSIGN);
+    node->left = create_node(p, AST_IDENTIFIER);
+    node->left->token = p->current;
+    advance(p);
+    if (!match(p, TOKEN_EQUALS)) {
+        parse_error(p, PARSE_ERROR_MISSING_EQUALS, p->current);
+        abort_parse(p);
+    }
+    advance(p);
+    node->right = parse_expression(p);
+    if (!match(p, TOKEN_SEMICOLON)) {
+        parse_error(p, PARSE_ERROR_MISSING_SEMICOLON, p->current);
+        abort_parse(p);
+    }
+    advance(p);
     return node;
 }
 
 // Parse if statement: if (condition) statement [else statement]
-static ASTNode *parse_if_statement(void) {
-    ASTNode *node = create_node(AST_IF);
-    advance(); // consume 'if'
-    expect(TOKEN_LPAREN);  // expect '('
-    node->left = parse_expression(); // condition stored in left child
-    expect(TOKEN_RPAREN);  // expect ')'
-    node->right = parse_block(); // then-branch
+static ASTNode *parse_if_statement(Parser *p) {
+    ASTNode *node = create_node(p, AST_IF);
+    advance(p); // consume 'if'
+    expect(p, TOKEN_LPAREN);  // expect '('
+    node->left = parse_expression(p); // condition stored in left child
+    expect(p, TOKEN_RPAREN);  // expect ')'
+    node->right = parse_block(p); // then-branch
     // Optionally parse else branch if present
-    if (match(TOKEN_IDENTIFIER) == 0 && strcmp(current_token.lexeme, "else") == 0) {
-        advance(); // consume 'else'
-        node->else_branch = parse_statement();
+    if (match(p, TOKEN_IDENTIFIER) && p->current.id == LEXEME_ELSE) {
+        advance(p); // consume 'else'
+        node->else_branch = parse_statement(p);
     }
     return node;
 }
 
 // Parse while loop: while (condition) statement
-static ASTNode *parse_while_statement(void) {
-    ASTNode *node = create_node(AST_WHILE);
-    advance(); // consume 'while'
-    expect(TOKEN_LPAREN);
-    node->left = parse_expression(); // condition
-    expect(TOKEN_RPAREN);
-    node->right = parse_block(); // loop body
+static ASTNode *parse_while_statement(Parser *p) {
+    ASTNode *node = create_node(p, AST_WHILE);
+    advance(p); // consume 'while'
+    expect(p, TOKEN_LPAREN);
+    node->left = parse_expression(p); // condition
+    expect(p, TOKEN_RPAREN);
+    node->right = parse_block(p); // loop body
     return node;
 }
 
 // Parse repeat-until loop: repeat statement until (condition);
-static ASTNode *parse_repeat_statement(void) {
-    ASTNode *node = create_node(AST_REPEAT);
-    advance(); // consume 'repeat'
-    node->left = parse_block(); // repeat body
-    if (!match(TOKEN_UNTIL)) {
-        parse_error(PARSE_ERROR_UNEXPECTED_TOKEN, current_token);
-        exit(1);
-    }
-    advance(); // consume 'until'
-    expect(TOKEN_LPAREN);
-    node->right = parse_expression(); // condition
-    expect(TOKEN_RPAREN);
-    expect(TOKEN_SEMICOLON);
+static ASTNode *parse_repeat_statement(Parser *p) {
+    ASTNode *node = create_node(p, AST_REPEAT);
+    advance(p); // consume 'repeat'
+    node->left = parse_block(p); // repeat body
+    if (!match(p, TOKEN_UNTIL)) {
+        parse_error(p, PARSE_ERROR_UNEXPECTED_TOKEN, p->current);
+        abort_parse(p);
+    }
+    advance(p); // consume 'until'
+    expect(p, TOKEN_LPAREN);
+    node->right = parse_expression(p); // condition
+    expect(p, TOKEN_RPAREN);
+    expect(p, TOKEN_SEMICOLON);
     return node;
 }
 
 // Parse print statement: print expression;
-static ASTNode *parse_print_statement(void) {
-    ASTNode *node = create_node(AST_PRINT);
-    advance(); // consume 'print'
-    node->left = parse_expression();
-    if (!match(TOKEN_SEMICOLON)) {
-        parse_error(PARSE_ERROR_MISSING_SEMICOLON, current_token);
-        exit(1);
-    }
-    advance();
+static ASTNode *parse_print_statement(Parser *p) {
+    ASTNode *node = create_node(p, AST_PRINT);
+    advance(p); // consume 'print'
+    node->left = parse_expression(p);
+    if (!match(p, TOKEN_SEMICOLON)) {
+        parse_error(p, PARSE_ERROR_MISSING_SEMICOLON, p->current);
+        abort_parse(p);
+    }
+    advance(p);
     return node;
 }
 
 // Parse a block: { statement1; statement2; ... }
-static ASTNode *parse_block(void) {
-    expect(TOKEN_LBRACE); // consume '{'
-    ASTNode *block_node = create_node(AST_BLOCK);
-    ASTNode *current = NULL;
-    while (!match(TOKEN_RBRACE) && !match(TOKEN_EOF)) {
-        ASTNode *stmt = parse_statement();
-        if (block_node->left == NULL) {
-            block_node->left = stmt;
-            current = block_node->left;
-        } else {
-            current->right = stmt;
-            current = current->right;
-        }
-    }
-    if (!match(TOKEN_RBRACE)) {
-        parse_error(PARSE_ERROR_MISSING_BLOCK, current_token);
-        exit(1);
+// Like a program, the AST_BLOCK node holds its statements in one array.
+static ASTNode *parse_block(Parser *p) {
+    expect(p, TOKEN_LBRACE); // consume '{'
+    ASTNode *block_node = create_node(p, AST_BLOCK);
+    parse_statement_list(p, block_node, TOKEN_RBRACE);
+    if (!match(p, TOKEN_RBRACE)) {
+        // Only the end of input can get here; keep what the block holds.
+        parse_error(p, PARSE_ERROR_MISSING_BLOCK, p->current);
+        return block_node;
     }
-    expect(TOKEN_RBRACE); // consume '}'
+    expect(p, TOKEN_RBRACE); // consume '}'
     return block_node;
 }
 
-// Parse factorial function call: factorial(expression)
-static ASTNode *parse_factorial(void) {
-    ASTNode *node = create_node(AST_FUNCALL);
-    node->token = current_token; // should be "factorial"
-    advance(); // consume 'factorial'
-    expect(TOKEN_LPAREN);
-    node->left = parse_expression(); // argument in left child
-    expect(TOKEN_RPAREN);
+// -----------------------------------------------------------------
+// Top-Level Statement Parsing
+// -----------------------------------------------------------------
+static ASTNode *parse_statement_kind(Parser *p) {
+    if (match(p, TOKEN_INT)) {
+        return parse_declaration(p);
+    } else if (match(p, TOKEN_IDENTIFIER)) {
+        // Could be an assignment (function calls are handled in parse_primary).
+        return parse_assignment(p);
+    } else if (match(p, TOKEN_IF)) {
+        return parse_if_statement(p);
+    } else if (match(p, TOKEN_WHILE)) {
+        return parse_while_statement(p);
+    } else if (match(p, TOKEN_REPEAT)) {
+        return parse_repeat_statement(p);
+    } else if (match(p, TOKEN_PRINT)) {
+        return parse_print_statement(p);
+    } else if (match(p, TOKEN_LBRACE)) {
+        return parse_block(p);
+    }
+    parse_error(p, PARSE_ERROR_UNEXPECTED_STATEMENT, p->current);
+    abort_parse(p);
+}
+
+// Parse one statement, one nesting level below the current position.
+// Recursion here follows the nesting of the source, which is bounded.
+static ASTNode *parse_statement(Parser *p) {
+    if (p->depth == PARSER_MAX_NESTING) {
+        parse_error(p, PARSE_ERROR_NESTING_TOO_DEEP, p->current);
+        abort_parse(p);
+    }
+    p->depth++;
+    ASTNode *node = parse_statement_kind(p);
+    p->depth--;
     return node;
 }
 
 // -----------------------------------------------------------------
-// Top-Level Statement Parsing
+// Error Recovery
 // -----------------------------------------------------------------
-static ASTNode *parse_statement(void) {
-    if (match(TOKEN_INT)) {
-        return parse_declaration();
-    } else if (match(TOKEN_IDENTIFIER)) {
-        // Could be an assignment (function calls are handled in parse_primary).
-        return parse_assignment();
-    } else if (match(TOKEN_IF)) {
-        return parse_if_statement();
-    } else if (match(TOKEN_WHILE)) {
-        return parse_while_statement();
-    } else if (match(TOKEN_REPEAT)) {
-        return parse_repeat_statement();
-    } else if (match(TOKEN_PRINT)) {
-        return parse_print_statement();
-    } else if (match(TOKEN_LBRACE)) {
-        return parse_block();
-    }
-    printf("Syntax Error: Unexpected token '%s'\n", current_token.lexeme);
-    exit(1);
+
+// Panic-mode recovery after an error in the statement that began at token
+// `start`: skip past the next ';' or the next whole '{ ... }' group (and
+// an 'else' group behind it), stopping before a '}' that closes the
+// enclosing block. Consumes at least one token, so a stray token cannot
+// stall the parse.
+static void synchronize(Parser *p, int start) {
+    int depth = 0;
+    while (!match(p, TOKEN_EOF)) {
+        if (match(p, TOKEN_LBRACE)) {
+            depth++;
+        } else if (match(p, TOKEN_RBRACE)) {
+            if (depth == 0) {
+                if (p->token_index == start) {
+                    advance(p);
+                }
+                return;
+            }
+            if (--depth == 0) {
+                advance(p);
+                if (!(match(p, TOKEN_IDENTIFIER) && p->current.id == LEXEME_ELSE)) {
+                    return;
+                }
+            }
+        } else if (match(p, TOKEN_SEMICOLON) && depth == 0) {
+            advance(p);
+            return;
+        }
+        advance(p);
+    }
 }
 
-// Parse a program: a sequence of statements.
-static ASTNode *parse_program(void) {
-    ASTNode *program = create_node(AST_PROGRAM);
-    ASTNode *current = program;
-    while (!match(TOKEN_EOF)) {
-        current->left = parse_statement();
-        if (!match(TOKEN_EOF)) {
-            current->right = create_node(AST_PROGRAM);
-            current = current->right;
+// Parse one statement; after a syntax error, resynchronize and return NULL.
+static ASTNode *parse_statement_recovering(Parser *p) {
+    jmp_buf outer;
+    memcpy(outer, p->on_error, sizeof(jmp_buf));
+    int start = p->token_index;
+    int depth = p->depth;
+    int pending = p->pending_count;
+    ASTNode *statement = NULL;
+    if (setjmp(p->on_error) == 0) {
+        statement = parse_statement(p);
+    } else {
+        p->depth = depth;
+        p->pending_count = pending;
+        synchronize(p, start);
+    }
+    memcpy(p->on_error, outer, sizeof(jmp_buf));
+    return statement;
+}
+
+// Append a parsed statement to the pending stack. Returns 0 if out of memory.
+static int push_pending(Parser *p, ASTNode *statement) {
+    if (p->pending_count == p->pending_capacity) {
+        int capacity = p->pending_capacity ? p->pending_capacity * 2 : 64;
+        ASTNode **grown = realloc(p->pending, (size_t)capacity * sizeof(ASTNode *));
+        if (!grown) {
+            return 0;
         }
+        p->pending = grown;
+        p->pending_capacity = capacity;
     }
+    p->pending[p->pending_count++] = statement;
+    return 1;
+}
+
+// Parse statements up to `end` (or the end of input) into the children of
+// `head`; statements with syntax errors are left out. The statements of
+// nested lists share one pending stack, so each list is copied into the
+// arena exactly once, when it is complete.
+static void parse_statement_list(Parser *p, ASTNode *head, TokenType end) {
+    int base = p->pending_count;
+    while (!match(p, end) && !match(p, TOKEN_EOF)) {
+        ASTNode *statement = parse_statement_recovering(p);
+        if (statement && !push_pending(p, statement)) {
+            break;
+        }
+    }
+    int count = p->pending_count - base;
+    if (count > 0) {
+        head->children = arena_alloc(&p->arena, (size_t)count * sizeof(ASTNode *));
+        if (head->children) {
+            memcpy(head->children, p->pending + base, (size_t)count * sizeof(ASTNode *));
+            head->child_count = count;
+        }
+    }
+    p->pending_count = base;
+}
+
+// Parse a program: a sequence of statements.
+static ASTNode *parse_program(Parser *p) {
+    ASTNode *program = create_node(p, AST_PROGRAM);
+    parse_statement_list(p, program, TOKEN_EOF);
     return program;
 }
 
 // -----------------------------------------------------------------
 // Parser Initialization and Main Parse Function
 // -----------------------------------------------------------------
-void parser_init(const char *input) {
-    source = input;
-    position = 0;
-    advance(); // get first token
+// Lex `input` into the context's own token buffer and string table.
+// A zero-initialized Parser may be passed; earlier trees stay valid until reset.
+// Returns 0 if lexing ran out of memory; the context then parses an empty stream.
+int parser_context_init(Parser *p, const char *input) {
+    if (!p->strings_ready) {
+        if (!lexer_init_strings(&p->strings)) {
+            p->owned_tokens.count = 0;
+            p->owned_tokens.strings = NULL;
+            parser_context_init_tokens(p, &p->owned_tokens);
+            return 0;
+        }
+        p->strings_ready = 1;
+    }
+    Lexer lexer;
+    lexer_init(&lexer, input, &p->strings);
+    int ok = lexer_tokenize(&lexer, &p->owned_tokens);
+    if (!ok) {
+        p->owned_tokens.count = 0;  // A stream cut short has no EOF to stop at
+    }
+    parser_context_init_tokens(p, &p->owned_tokens);
+    return ok;
+}
+
+// Parse an already lexed stream; it must stay alive until parsing is done.
+void parser_context_init_tokens(Parser *p, const TokenBuffer *stream) {
+    p->tokens = stream;
+    p->ring = NULL;
+    p->token_index = 0;
+    p->current = token_at(p->tokens, 0); // get first token
+}
+
+// Parse tokens as another thread pushes them (see pipeline.h). Waits for
+// the first token; the consumer side of the ring belongs to the parser.
+void parser_context_init_ring(Parser *p, SpscRing *ring) {
+    p->tokens = NULL;
+    p->ring = ring;
+    p->token_index = 0;
+    p->current = fetch(p, 0);
+}
+
+// Parse the whole stream, recovering from every syntax error. Errors are
+// recorded in p->diagnostics; the tree holds the statements that parsed.
+ASTNode *parser_context_parse_partial(Parser *p) {
+    diagnostics_clear(&p->diagnostics);
+    p->depth = 0;
+    p->pending_count = 0;
+    if (setjmp(p->on_error)) {
+        return NULL;  // Not reached: every statement recovers on its own
+    }
+    STATS_START(timer);
+    ASTNode *program = parse_program(p);
+    STATS_STOP(STATS_PARSE, timer);
+    return program;
+}
+
+// Parse the next top-level statement, recovering from a syntax error as
+// parser_context_parse_partial does; diagnostics accumulate across calls.
+// Returns 0 at the end of the stream, otherwise 1 with *statement set
+// (NULL if the statement had a syntax error).
+int parser_context_parse_next(Parser *p, ASTNode **statement) {
+    if (match(p, TOKEN_EOF)) {
+        return 0;
+    }
+    p->depth = 0;
+    p->pending_count = 0;
+    *statement = parse_statement_recovering(p);
+    return 1;
+}
+
+// Returns NULL (with every error recorded) if the input has a syntax error.
+ASTNode *parser_context_parse(Parser *p) {
+    ASTNode *program = parser_context_parse_partial(p);
+    return p->diagnostics.count ? NULL : program;
+}
+
+// Free every node of the context at once; tokens and lexemes are kept.
+void parser_context_reset(Parser *p) {
+    arena_reset(&p->arena);
+}
+
+// Free every node, token and lexeme owned by the context.
+void parser_context_destroy(Parser *p) {
+    arena_destroy(&p->arena);
+    free_token_buffer(&p->owned_tokens);
+    diagnostics_free(&p->diagnostics);
+    free(p->pending);
+    if (p->strings_ready) {
+        intern_free(&p->strings);
+    }
+    memset(p, 0, sizeof(*p));
+}
+
+// Global API: thin wrappers over the default context.
+int parser_init(const char *input) {
+    return parser_context_init(&default_parser, input);
+}
+
+void parser_init_tokens(const TokenBuffer *stream) {
+    parser_context_init_tokens(&default_parser, stream);
 }
 
 ASTNode *parse(void) {
-    return parse_program();
+    ASTNode *program = parser_context_parse(&default_parser);
+    diagnostics_print(default_parser.diagnostics.items, default_parser.diagnostics.count,
+                      DIAGNOSTICS_TEXT, NULL, stdout);
+    return program;
 }
 
 // -----------------------------------------------------------------
 // AST Debug Printing and Memory Cleanup
 // -----------------------------------------------------------------
-void print_ast(ASTNode *node, int level) {
-    if (!node) return;
+#define AST_KIND_INFO(kind, label, shows_lexeme, children) [kind] = {label, shows_lexeme, children},
+const ASTKindInfo ast_kinds[AST_KIND_COUNT] = {
+    AST_NODE_KINDS(AST_KIND_INFO)
+};
+#undef AST_KIND_INFO
+
+// Print the one-line description of a node (no indentation).
+void print_ast_label(FILE *out, ASTNodeType type, const char *lexeme) {
+    if ((unsigned int)type >= AST_KIND_COUNT) {
+        fprintf(out, "Unknown node type\n");
+    } else if (ast_kinds[type].shows_lexeme) {
+        fprintf(out, "%s: %s\n", ast_kinds[type].label, lexeme);
+    } else {
+        fprintf(out, "%s\n", ast_kinds[type].label);
+    }
+}
+
+// Indentation of the next node print_ast enters.
+typedef struct {
+    int level;
+} PrintState;
+
+static void print_indent(int level) {
     for (int i = 0; i < level; i++) printf("  ");
-    switch (node->type) {
-        case AST_PROGRAM:
-            printf("Program\n");
-            break;
-        case AST_VARDECL:
-            printf("VarDecl: %s\n", node->token.lexeme);
-            break;
-        case AST_ASSIGN:
-            printf("Assign\n");
-            break;
-        case AST_NUMBER:
-            printf("Number: %s\n", node->token.lexeme);
-            break;
-        case AST_IDENTIFIER:
-            printf("Identifier: %s\n", node->token.lexeme);
-            break;
-        case AST_BINOP:
-            printf("BinaryOp: %s\n", node->token.lexeme);
-            break;
-        case AST_IF:
-            printf("If\n");
-            break;
-        case AST_WHILE:
-            printf("While\n");
-            break;
-        case AST_REPEAT:
-            printf("Repeat-Until\n");
-            break;
-        case AST_PRINT:
-            printf("Print\n");
-            break;
-        case AST_BLOCK:
-            printf("Block\n");
-            break;
-        case AST_FUNCALL:
-            printf("FuncCall: %s\n", node->token.lexeme);
-            break;
-        default:
-            printf("Unknown node type\n");
-    }
-    print_ast(node->left, level + 1);
-    print_ast(node->right, level + 1);
-    // Print else branch if it exists (for if statements)
-    if (node->else_branch) {
-        for (int i = 0; i < level + 1; i++) printf("  ");
+}
+
+static AstWalkAction print_enter(const AstVisit *visit, void *context) {
+    PrintState *state = context;
+    // An else branch is printed under an "Else:" line of its own.
+    if (visit->field == AST_FIELD_ELSE) {
+        print_indent(state->level);
         printf("Else:\n");
-        print_ast(node->else_branch, level + 2);
+        state->level++;
     }
+    print_indent(state->level);
+    print_ast_label(stdout, visit->node->type, visit->node->token.lexeme);
+    state->level++;
+    return AST_WALK_CONTINUE;
 }
 
-void free_ast(ASTNode *node) {
-    if (!node) return;
-    free_ast(node->left);
-    free_ast(node->right);
-    free_ast(node->else_branch);
-    free(node);
+static void print_leave(const AstVisit *visit, void *context) {
+    PrintState *state = context;
+    state->level -= visit->field == AST_FIELD_ELSE ? 2 : 1;
 }
 
-// -----------------------------------------------------------------
-// Main Function for Testing
-// -----------------------------------------------------------------
-char* read_file(const char* filename) {
-    FILE *file = fopen(filename, "rb");  // Open in binary mode
-    if (!file) {
-        perror("Error opening file");
-        return NULL;
-    }
-    fseek(file, 0L, SEEK_END);
-    long size = ftell(file);
-    rewind(file);
-    if (size < 0) {
-        fclose(file);
-        perror("ftell failed");
-        return NULL;
-    }
-    char *buffer = (char *)malloc(size + 1);
-    if (!buffer) {
-        fclose(file);
-        perror("Memory allocation failed");
-        return NULL;
-    }
-    size_t bytesRead = fread(buffer, 1, size, file);
-    buffer[bytesRead] = '\0';
-    fclose(file);
-    for (char* p = buffer; *p; ++p) {
-        if (*p == '\r') {
-            *p = ' ';
-        }
-    }
-    return buffer;
+// Print the tree one node per line, each child indented under its parent.
+void print_ast(ASTNode *node, int level) {
+    PrintState state = {level};
+    AstVisitor printer = {print_enter, print_leave, &state};
+    ast_walk(node, &printer, 1);
 }
 
-int main() {
-    const char *valid_filename = "phase3-w25/test/input_valid.txt";
-    const char *invalid_filename = "phase3-w25/test/input_invalid.txt";    
+// Nodes are carved out of the parser arena, so freeing a tree is a single
+// arena reset rather than a recursive walk.
+void free_ast(ASTNode *node) {
+    if (!node) return;
+    parser_arena_reset();
+}
 
-    printf("Parsing valid input from %s:\n", valid_filename);
-    char *valid_input = read_file(valid_filename);
-    if (valid_input) {
-        printf("Input:\n%s\n", valid_input);
-        parser_init(valid_input);
-        ASTNode *ast = parse();
-        if (ast) {
-            printf("\nAbstract Syntax Tree for valid input:\n");
-            print_ast(ast, 0);
-            free_ast(ast);
-        } else {
-            printf("Error parsing valid input.\n");
-        }
-        free(valid_input);
-    }
+// Release every node allocated since the last reset; one chunk is kept for the next parse.
+void parser_arena_reset(void) {
+    parser_context_reset(&default_parser);
+}
 
-    printf("\nParsing invalid input from %s:\n", invalid_filename);
-    char *invalid_input = read_file(invalid_filename);
-    if (invalid_input) {
-        printf("Input:\n%s\n", invalid_input);
-        parser_init(invalid_input);
-        ASTNode *ast = parse();
-        if (!ast) {
-            printf("Error parsing invalid input as expected.\n");
-        } else {
-            printf("\nAbstract Syntax Tree for invalid input (unexpected):\n");
-            print_ast(ast, 0);
-            free_ast(ast);
-        }
-        free(invalid_input);
-    }
+// Release all memory held by the parser arena.
+void parser_arena_destroy(void) {
+    arena_destroy(&default_parser.arena);
+}
 
-    return 0;
+// Release everything held by the default context (nodes, tokens, lexemes).
+void parser_cleanup(void) {
+    parser_context_destroy(&default_parser);
 }
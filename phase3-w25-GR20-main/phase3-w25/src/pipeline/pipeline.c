@@ -0,0 +1,216 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "../../include/pipeline.h"
+#include "../../include/lexer.h"
+#include "../../include/semantic.h"
+#include "../../include/spsc_ring.h"
+#include "../../include/stats.h"
+
+// -----------------------------------------------------------------
+// Stages. Each ring has exactly one producer and one consumer thread:
+// lexer -> tokens -> parser -> statements -> checker.
+// -----------------------------------------------------------------
+
+typedef struct {
+    Lexer lexer;
+    SpscRing* tokens;
+    int count;                // Tokens pushed, including EOF
+    int failed;               // 1 if a lexeme could not be interned
+    FrontendStats stats;      // What the stage counted on its thread
+} LexStage;
+
+typedef struct {
+    Parser* parser;
+    SpscRing* statements;     // Ring of ASTNode*; only parsed statements are pushed
+    FrontendStats stats;
+} ParseStage;
+
+typedef struct {
+    SymbolTable* table;
+    ASTNode** statements;     // Every statement checked so far, in order
+    int count;
+    int capacity;
+    int valid;
+} CheckStage;
+
+static void* lex_stage(void* context) {
+    LexStage* stage = context;
+    STATS_START(timer);
+    for (;;) {
+        Token token = lexer_next_token(&stage->lexer);
+        if (token.id >= stage->lexer.strings->count) {
+            // Out of memory: end the stream here so the parser stops.
+            stage->failed = 1;
+            token.type = TOKEN_EOF;
+            token.id = LEXEME_EOF;
+            token.lexeme = intern_string(stage->lexer.strings, LEXEME_EOF);
+        }
+        spsc_ring_push(stage->tokens, &token);
+        stage->count++;
+        if (token.type == TOKEN_EOF) {
+            break;
+        }
+    }
+    spsc_ring_close(stage->tokens);
+    STATS_STOP(STATS_LEX, timer);
+    stats_take(&stage->stats);
+    return NULL;
+}
+
+static void* parse_stage(void* context) {
+    ParseStage* stage = context;
+    ASTNode* statement;
+    STATS_START(timer);
+    while (parser_context_parse_next(stage->parser, &statement)) {
+        if (statement) {
+            spsc_ring_push(stage->statements, &statement);
+        }
+    }
+    spsc_ring_close(stage->statements);
+    STATS_STOP(STATS_PARSE, timer);
+    stats_take(&stage->stats);
+    return NULL;
+}
+
+// Check one statement, exactly as check_program's loop would, and keep it
+// for the program node.
+static void check_stage(CheckStage* stage, ASTNode* statement) {
+    stage->valid &= check_statement(statement, stage->table);
+    if (stage->count == stage->capacity) {
+        int capacity = stage->capacity ? stage->capacity * 2 : 256;
+        ASTNode** grown = realloc(stage->statements, (size_t)capacity * sizeof(ASTNode*));
+        if (!grown) {
+            return;
+        }
+        stage->statements = grown;
+        stage->capacity = capacity;
+    }
+    stage->statements[stage->count++] = statement;
+}
+
+// Program node over the checked statements, in the parser's arena.
+static ASTNode* build_program(Parser* parser, Token first, const CheckStage* stage) {
+    ASTNode* program = arena_alloc(&parser->arena, sizeof(ASTNode));
+    if (!program) {
+        return NULL;
+    }
+    memset(program, 0, sizeof(ASTNode));
+    program->type = AST_PROGRAM;
+    program->token = first;
+    program->slot = -1;
+    program->depth = -1;
+    if (stage->count > 0) {
+        program->children = arena_alloc(&parser->arena, (size_t)stage->count * sizeof(ASTNode*));
+        if (program->children) {
+            memcpy(program->children, stage->statements, (size_t)stage->count * sizeof(ASTNode*));
+            program->child_count = stage->count;
+        }
+    }
+    return program;
+}
+
+// -----------------------------------------------------------------
+// Driver. Semantic errors stay in the checker's table until the end: a
+// syntax error found later would mean they must not be reported at all.
+// -----------------------------------------------------------------
+
+int pipeline_run(Parser* parser, const char* input, DiagnosticList* semantic, PipelineResult* result) {
+    SpscRing tokens, statements;
+    if (!spsc_ring_init(&tokens, sizeof(Token), PIPELINE_TOKEN_CAPACITY)) {
+        return 0;
+    }
+    if (!spsc_ring_init(&statements, sizeof(ASTNode*), PIPELINE_STATEMENT_CAPACITY)) {
+        spsc_ring_destroy(&tokens);
+        return 0;
+    }
+    CheckStage check = {0};
+    check.valid = 1;
+    check.table = init_symbol_table();
+    if (!check.table) {
+        spsc_ring_destroy(&tokens);
+        spsc_ring_destroy(&statements);
+        return 0;
+    }
+
+    if (!parser->strings_ready) {
+        if (!lexer_init_strings(&parser->strings)) {
+            free_symbol_table(check.table);
+            spsc_ring_destroy(&tokens);
+            spsc_ring_destroy(&statements);
+            return 0;
+        }
+        parser->strings_ready = 1;
+    }
+    LexStage lex;
+    lexer_init(&lex.lexer, input, &parser->strings);
+    lex.tokens = &tokens;
+    lex.count = 0;
+    lex.failed = 0;
+    memset(&lex.stats, 0, sizeof(lex.stats));
+    pthread_t lex_thread;
+    if (pthread_create(&lex_thread, NULL, lex_stage, &lex) != 0) {
+        free_symbol_table(check.table);
+        spsc_ring_destroy(&tokens);
+        spsc_ring_destroy(&statements);
+        return 0;
+    }
+
+    parser_context_init_ring(parser, &tokens);
+    Token first = parser->current;
+    ParseStage parse = {.parser = parser, .statements = &statements};
+    pthread_t parse_thread;
+    if (pthread_create(&parse_thread, NULL, parse_stage, &parse) == 0) {
+        // Stage times include waiting on the rings, so they overlap.
+        STATS_START(timer);
+        const void* slot;
+        for (size_t i = 0; (slot = spsc_ring_get(&statements, i)) != NULL; i++) {
+            ASTNode* statement = *(ASTNode* const*)slot;
+            spsc_ring_release(&statements, i + 1);
+            check_stage(&check, statement);
+        }
+        STATS_STOP(STATS_CHECK, timer);
+        pthread_join(parse_thread, NULL);
+        stats_put(&parse.stats);
+    } else {
+        // No second thread: parse and check alternately on this one.
+        ASTNode* statement;
+        while (parser_context_parse_next(parser, &statement)) {
+            if (statement) {
+                check_stage(&check, statement);
+            }
+        }
+    }
+    pthread_join(lex_thread, NULL);
+    stats_put(&lex.stats);
+    parser->ring = NULL;
+    if (lex.failed) {
+        // The statements stop short of the input: drop them and report failure.
+        parser_context_reset(parser);
+        diagnostics_clear(&parser->diagnostics);
+        free(check.statements);
+        free_symbol_table(check.table);
+        spsc_ring_destroy(&tokens);
+        spsc_ring_destroy(&statements);
+        return 0;
+    }
+
+    result->program = build_program(parser, first, &check);
+    result->tokens = lex.count;
+    result->syntax_errors = parser->diagnostics.count;
+    result->valid = result->syntax_errors == 0 && check.valid;
+    result->slot_count = check.table->slot_count;
+    if (result->program) {
+        result->program->depth = 0;
+        result->program->frame_size = result->slot_count;
+    }
+    if (result->syntax_errors == 0) {
+        diagnostics_append(semantic, check.table->diagnostics.items, check.table->diagnostics.count);
+    }
+    free(check.statements);
+    free_symbol_table(check.table);
+    spsc_ring_destroy(&tokens);
+    spsc_ring_destroy(&statements);
+    return 1;
+}
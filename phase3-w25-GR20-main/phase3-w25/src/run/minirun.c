@@ -0,0 +1,184 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/parser.h"
+#include "../../include/semantic.h"
+#include "../../include/source.h"
+#include "../../include/interpreter.h"
+#include "../../include/bytecode.h"
+#include "../../include/bytecode_cache.h"
+#include "../../include/jit.h"
+#include "../../include/optimizer.h"
+#include "../../include/stats.h"
+
+// -----------------------------------------------------------------
+// Script runner: lex, parse and check one source file, then execute it
+// on the bytecode VM (or the tree walker with --tree); hot loops are
+// compiled to machine code unless --no-jit is given.
+// Print statements go to stdout; diagnostics go to stderr. With --cache
+// an unchanged source runs straight from its cached bytecode image.
+// --stats reports the phase times and counters on stderr at the end.
+// -----------------------------------------------------------------
+
+static void usage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s [--cache DIR] [--symbols] [--no-fold] [--no-jit] [--stats | --stats-json] [--ast | --tree | --disassemble] file\n"
+            "  --cache DIR     reuse and update compiled images in DIR\n"
+            "  --symbols       dump the symbol table after semantic analysis\n"
+            "  --no-fold       skip constant folding\n"
+            "  --no-jit        interpret every loop on the VM\n"
+            "  --stats         print phase times and counters to stderr\n"
+            "  --stats-json    the same as one JSON object\n"
+            "  --ast           print the (folded) AST instead of running it\n"
+            "  --tree          run on the tree-walking interpreter instead of the VM\n"
+            "  --disassemble   print the bytecode instead of running it\n",
+            program);
+}
+
+// Slurp a temporary stream into a heap string and close it.
+static char* drain_stream(FILE* stream) {
+    long size = ftell(stream);
+    char* text = malloc(size > 0 ? size + 1 : 1);
+    if (text) {
+        rewind(stream);
+        size_t read = size > 0 ? fread(text, 1, size, stream) : 0;
+        text[read] = '\0';
+    }
+    fclose(stream);
+    return text;
+}
+
+// Disassemble or execute a compiled program; returns the exit status.
+static int run_chunk(const Chunk* chunk, int disassemble, int jit_threshold) {
+    if (disassemble) {
+        chunk_disassemble(chunk, stdout);
+        return 0;
+    }
+    return vm_run_jit(chunk, stdout, jit_threshold) ? 0 : 1;
+}
+
+// Print what this thread counted, if --stats (0) or --stats-json (1) asked.
+static void report_stats(int format) {
+    if (format >= 0) {
+        FrontendStats stats = {0};
+        stats_take(&stats);
+        stats_print(&stats, format, stderr);
+    }
+}
+
+int main(int argc, char** argv) {
+    const char* path = NULL;
+    const char* cache_dir = NULL;
+    int dump_table = 0;
+    int tree = 0;
+    int disassemble = 0;
+    int fold = 1;
+    int show_ast = 0;
+    int jit_threshold = JIT_DEFAULT_THRESHOLD;
+    int stats = -1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            cache_dir = argv[++i];
+        } else if (strcmp(argv[i], "--symbols") == 0) {
+            dump_table = 1;
+        } else if (strcmp(argv[i], "--tree") == 0) {
+            tree = 1;
+        } else if (strcmp(argv[i], "--disassemble") == 0) {
+            disassemble = 1;
+        } else if (strcmp(argv[i], "--no-fold") == 0) {
+            fold = 0;
+        } else if (strcmp(argv[i], "--no-jit") == 0) {
+            jit_threshold = 0;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            stats = 0;
+        } else if (strcmp(argv[i], "--stats-json") == 0) {
+            stats = 1;
+        } else if (strcmp(argv[i], "--ast") == 0) {
+            show_ast = 1;
+        } else if (argv[i][0] == '-' || path) {
+            usage(argv[0]);
+            return 2;
+        } else {
+            path = argv[i];
+        }
+    }
+    if (!path) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    SourceFile source;
+    if (!source_open(&source, path)) {
+        return 1;
+    }
+    // The cache holds folded VM images only, and a symbol dump needs the analysis.
+    int use_cache = cache_dir && !tree && !dump_table && !show_ast && fold;
+    if (use_cache) {
+        CachedProgram cached;
+        if (bytecode_cache_load(cache_dir, source.data, source.size, &cached)) {
+            fputs(cached.diagnostics, stderr);
+            int status = run_chunk(&cached.chunk, disassemble, jit_threshold);
+            bytecode_cache_close(&cached);
+            source_close(&source);
+            report_stats(stats);
+            return status;
+        }
+    }
+
+    // Capture diagnostics when caching so a later hit can replay them.
+    FILE* diagnostics = use_cache ? tmpfile() : NULL;
+    if (!diagnostics) {
+        diagnostics = stderr;
+    }
+    Parser parser = {0};
+    if (!parser_context_init(&parser, source.data)) {
+        fprintf(stderr, "%s: out of memory\n", path);
+        if (diagnostics != stderr) {
+            fclose(diagnostics);
+        }
+        parser_context_destroy(&parser);
+        source_close(&source);
+        return 1;
+    }
+    ASTNode* ast = parser_context_parse(&parser);
+    diagnostics_print(parser.diagnostics.items, parser.diagnostics.count, DIAGNOSTICS_TEXT, NULL,
+                      diagnostics);
+
+    int status = 1;
+    int slot_count = 0;
+    int checked = ast && analyze_semantics_slots(ast, diagnostics, dump_table, &slot_count);
+    char* messages = NULL;
+    if (diagnostics != stderr) {
+        messages = drain_stream(diagnostics);
+        if (messages) {
+            fputs(messages, stderr);
+        }
+    }
+    if (checked && fold) {
+        fold_constants(ast, &parser.strings, NULL);
+    }
+    if (checked) {
+        Chunk chunk;
+        if (show_ast) {
+            print_ast(ast, 0);
+            status = 0;
+        } else if (tree) {
+            status = interpret(ast, slot_count, stdout) ? 0 : 1;
+        } else if (!bytecode_compile(ast, slot_count, &chunk)) {
+            fprintf(stderr, "Error: program is too large to compile to bytecode\n");
+        } else {
+            if (messages) {
+                bytecode_cache_store(cache_dir, source.data, source.size, &chunk,
+                                     parser.owned_tokens.count, messages);
+            }
+            status = run_chunk(&chunk, disassemble, jit_threshold);
+            chunk_free(&chunk);
+        }
+    }
+    free(messages);
+
+    parser_context_destroy(&parser);
+    source_close(&source);
+    report_stats(stats);
+    return status;
+}
@@ -0,0 +1,425 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include "../../include/parallel_check.h"
+#include "../../include/semantic.h"
+#include "../../include/ast_visit.h"
+#include "../../include/thread_pool.h"
+#include "../../include/stats.h"
+
+// Slots given out while checking a block against the snapshot; the last
+// pass replaces them with real ones. Both lie far above any real slot.
+#define LOCAL_SLOT_BASE  (1 << 30)  // Provisional slot of a block's first local
+#define GLOBAL_SLOT_BASE (1 << 29)  // Provisional slot of global number 0
+#define NEVER INT_MAX
+
+// -----------------------------------------------------------------
+// Global snapshot: every name declared at top level, by first
+// declaration. Built once, then only read by the workers.
+// -----------------------------------------------------------------
+
+typedef struct {
+    const char* name;         // Interned name
+    int declared_at;          // Statement that declares it
+    int assigned_at;          // First non-block statement assigning it (NEVER = none)
+    int slot;                 // Real slot, set when the merge reaches declared_at
+} Global;
+
+typedef struct {
+    Global* globals;
+    int count;
+    int capacity;
+    int* index;               // Hash slots: global number + 1 (0 = empty)
+    unsigned int mask;        // Hash slot count - 1
+} Snapshot;
+
+// Hash an interned name by its address, as the symbol table does.
+static unsigned int hash_name(const char* name) {
+    uintptr_t bits = (uintptr_t)name >> 3;
+    return (unsigned int)(bits * 2654435761u);
+}
+
+// Global number of `name`, or -1.
+static int find_global(const Snapshot* snapshot, const char* name) {
+    unsigned int i = hash_name(name) & snapshot->mask;
+    while (snapshot->index[i]) {
+        int global = snapshot->index[i] - 1;
+        if (snapshot->globals[global].name == name) {
+            return global;
+        }
+        i = (i + 1) & snapshot->mask;
+    }
+    return -1;
+}
+
+static int grow_snapshot(Snapshot* snapshot) {
+    int capacity = snapshot->capacity ? snapshot->capacity * 2 : 64;
+    Global* globals = realloc(snapshot->globals, (size_t)capacity * sizeof(Global));
+    int* index = calloc((size_t)capacity * 2, sizeof(int));
+    if (!globals || !index) {
+        if (globals) snapshot->globals = globals;
+        free(index);
+        return 0;
+    }
+    free(snapshot->index);
+    snapshot->globals = globals;
+    snapshot->capacity = capacity;
+    snapshot->index = index;
+    snapshot->mask = (unsigned int)capacity * 2 - 1;
+    for (int g = 0; g < snapshot->count; g++) {
+        unsigned int i = hash_name(globals[g].name) & snapshot->mask;
+        while (index[i]) i = (i + 1) & snapshot->mask;
+        index[i] = g + 1;
+    }
+    return 1;
+}
+
+static int add_global(Snapshot* snapshot, const char* name, int statement) {
+    if (find_global(snapshot, name) >= 0) {
+        return 1;  // Redeclared: the first declaration stays
+    }
+    if (snapshot->count == snapshot->capacity && !grow_snapshot(snapshot)) {
+        return 0;
+    }
+    Global* global = &snapshot->globals[snapshot->count];
+    global->name = name;
+    global->declared_at = statement;
+    global->assigned_at = NEVER;
+    global->slot = -1;
+    unsigned int i = hash_name(name) & snapshot->mask;
+    while (snapshot->index[i]) i = (i + 1) & snapshot->mask;
+    snapshot->index[i] = ++snapshot->count;
+    return 1;
+}
+
+typedef struct {
+    Snapshot* snapshot;
+    int statement;
+} AssignmentNotes;
+
+static AstWalkAction note_assignment(const AstVisit* visit, void* context) {
+    AssignmentNotes* notes = context;
+    Snapshot* snapshot = notes->snapshot;
+    int statement = notes->statement;
+    const ASTNode* node = visit->node;
+    if (node->type == AST_ASSIGN && node->left) {
+        int global = find_global(snapshot, node->left->token.lexeme);
+        if (global >= 0 && snapshot->globals[global].declared_at < statement &&
+            snapshot->globals[global].assigned_at == NEVER) {
+            snapshot->globals[global].assigned_at = statement;
+        }
+    }
+    return AST_WALK_CONTINUE;
+}
+
+// Note the globals assigned anywhere in `node` as initialized from
+// `statement` on. Only a guess: an assignment with a bad right-hand side
+// or to a shadowing local initializes nothing, which the merge catches.
+static void note_assignments(Snapshot* snapshot, ASTNode* node, int statement) {
+    AssignmentNotes notes = {snapshot, statement};
+    AstVisitor visitor = {note_assignment, NULL, &notes};
+    ast_walk(node, &visitor, 1);
+}
+
+// -----------------------------------------------------------------
+// Checking blocks against the snapshot (thread pool jobs)
+// -----------------------------------------------------------------
+
+typedef struct {
+    int global;               // Global number
+    int assumed;              // is_initialized the block was checked with
+    int initialized;          // is_initialized after the block
+} GlobalUse;
+
+typedef struct {
+    int statement;            // Index among the program's statements
+    int job;                  // Job whose list holds its diagnostics
+    int checked;              // 0 if its job failed; the merge checks it instead
+    int valid;                // check_block's result under the snapshot
+    int local_slots;          // Slots its own declarations took
+    int diagnostics_start;    // Its diagnostics in the job's list
+    int diagnostics_end;
+    GlobalUse* uses;          // Globals it mentions, in first-use order
+    int use_count;
+    int use_capacity;
+    int base;                 // Real slot of its first local (-1 = checked by the merge)
+} BlockResult;
+
+typedef struct {
+    DiagnosticList diagnostics;  // The job's diagnostics, block after block
+    FrontendStats stats;      // What its thread counted for it
+    int first;                // Blocks [first, end)
+    int end;
+} Job;
+
+typedef struct {
+    ASTNode* program;
+    Snapshot snapshot;
+    BlockResult* blocks;
+    int block_count;
+    Job* jobs;
+    int job_count;
+    FrontendStats caller;     // The calling thread's record while the jobs run
+} ParallelCheck;
+
+// Per-job state while checking: one table for all its blocks, and the
+// copies of the snapshot's globals that the table resolves names to.
+typedef struct {
+    ParallelCheck* check;
+    BlockResult* block;       // Block being checked
+    int block_number;
+    Symbol* copies;           // Per global: its symbol in the current block
+    int* seen;                // Per global: number (+1) of the last block that used it
+    int failed;               // Out of memory while checking the current block
+} BlockChecker;
+
+// SymbolTable.resolve: a global declared before the block, as the block
+// was assumed to see it. The first use in a block records it.
+static Symbol* resolve_global(void* context, const char* name) {
+    BlockChecker* checker = context;
+    const Snapshot* snapshot = &checker->check->snapshot;
+    BlockResult* block = checker->block;
+    int global = find_global(snapshot, name);
+    if (global < 0 || snapshot->globals[global].declared_at >= block->statement) {
+        return NULL;
+    }
+    Symbol* symbol = &checker->copies[global];
+    if (checker->seen[global] != checker->block_number + 1) {
+        checker->seen[global] = checker->block_number + 1;
+        if (block->use_count == block->use_capacity) {
+            int capacity = block->use_capacity ? block->use_capacity * 2 : 8;
+            GlobalUse* uses = realloc(block->uses, (size_t)capacity * sizeof(GlobalUse));
+            if (!uses) {
+                checker->failed = 1;
+                return symbol;
+            }
+            block->uses = uses;
+            block->use_capacity = capacity;
+        }
+        GlobalUse* use = &block->uses[block->use_count++];
+        use->global = global;
+        use->assumed = snapshot->globals[global].assigned_at < block->statement;
+        symbol->name = name;
+        symbol->type = TOKEN_INT;
+        symbol->scope_level = 0;
+        symbol->line_declared = 0;
+        symbol->is_initialized = use->assumed;
+        symbol->slot = GLOBAL_SLOT_BASE + global;
+        symbol->next = NULL;
+    }
+    return symbol;
+}
+
+static void check_job(void* context, int index) {
+    ParallelCheck* check = context;
+    Job* job = &check->jobs[index];
+    BlockChecker checker = {check, NULL, 0, NULL, NULL, 0};
+    checker.copies = malloc(((size_t)check->snapshot.count + 1) * sizeof(Symbol));
+    checker.seen = calloc((size_t)check->snapshot.count + 1, sizeof(int));
+    SymbolTable* table = init_symbol_table();
+    if (!checker.copies || !checker.seen || !table) {
+        if (table) free_symbol_table(table);
+        free(checker.copies);
+        free(checker.seen);
+        return;  // Blocks stay unchecked
+    }
+    table->resolve = resolve_global;
+    table->resolve_context = &checker;
+
+    // A block leaves the table as it found it: top-level scope, nothing live.
+    for (int b = job->first; b < job->end; b++) {
+        BlockResult* block = &check->blocks[b];
+        checker.block = block;
+        checker.block_number = b;
+        checker.failed = 0;
+        table->slot_count = LOCAL_SLOT_BASE;
+        int dropped = table->diagnostics.dropped;
+        block->diagnostics_start = table->diagnostics.count;
+        block->valid = check_statement(check->program->children[block->statement], table);
+        block->diagnostics_end = table->diagnostics.count;
+        block->local_slots = table->slot_count - LOCAL_SLOT_BASE;
+        for (int i = 0; i < block->use_count; i++) {
+            block->uses[i].initialized = checker.copies[block->uses[i].global].is_initialized;
+        }
+        block->checked = !checker.failed && table->diagnostics.dropped == dropped;
+    }
+    job->diagnostics = table->diagnostics;  // Keep the records for the merge
+    memset(&table->diagnostics, 0, sizeof(table->diagnostics));
+    free_symbol_table(table);
+    free(checker.copies);
+    free(checker.seen);
+    stats_take(&job->stats);
+}
+
+// -----------------------------------------------------------------
+// Serial merge and slot fix-up
+// -----------------------------------------------------------------
+
+// Keep a block's result if it was checked with the globals' real state.
+static int accept_block(ParallelCheck* check, BlockResult* block, SymbolTable* table) {
+    if (!block->checked) {
+        return 0;
+    }
+    for (int i = 0; i < block->use_count; i++) {
+        Symbol* symbol = lookup_symbol(table, check->snapshot.globals[block->uses[i].global].name);
+        if (!symbol || symbol->is_initialized != block->uses[i].assumed) {
+            return 0;
+        }
+    }
+    for (int i = 0; i < block->use_count; i++) {
+        if (block->uses[i].initialized) {
+            lookup_symbol(table, check->snapshot.globals[block->uses[i].global].name)->is_initialized = 1;
+        }
+    }
+    block->base = table->slot_count;
+    table->slot_count += block->local_slots;
+    diagnostics_append(&table->diagnostics, check->jobs[block->job].diagnostics.items + block->diagnostics_start,
+                       block->diagnostics_end - block->diagnostics_start);
+    return 1;
+}
+
+static int merge(ParallelCheck* check, SymbolTable* table) {
+    int valid = 1;
+    int next_block = 0;
+    for (int i = 0; i < check->program->child_count; i++) {
+        ASTNode* statement = check->program->children[i];
+        if (next_block < check->block_count && check->blocks[next_block].statement == i) {
+            BlockResult* block = &check->blocks[next_block++];
+            if (accept_block(check, block, table)) {
+                valid &= block->valid;
+                continue;
+            }
+            block->base = -1;
+        }
+        valid &= check_statement(statement, table);
+        if (statement && statement->type == AST_VARDECL) {
+            int global = find_global(&check->snapshot, statement->token.lexeme);
+            Symbol* symbol = lookup_symbol(table, statement->token.lexeme);
+            if (global >= 0 && check->snapshot.globals[global].declared_at == i && symbol) {
+                check->snapshot.globals[global].slot = symbol->slot;
+            }
+        }
+    }
+    return valid;
+}
+
+// Replace the provisional slots in a kept block's tree.
+static void fix_slots(const Snapshot* snapshot, ASTNode* node, int base) {
+    if (!node) return;
+    if (node->slot >= LOCAL_SLOT_BASE) {
+        node->slot = base + (node->slot - LOCAL_SLOT_BASE);
+    } else if (node->slot >= GLOBAL_SLOT_BASE) {
+        node->slot = snapshot->globals[node->slot - GLOBAL_SLOT_BASE].slot;
+    }
+    for (int i = 0; i < node->child_count; i++)
+        fix_slots(snapshot, node->children[i], base);
+    fix_slots(snapshot, node->left, base);
+    fix_slots(snapshot, node->right, base);
+    fix_slots(snapshot, node->else_branch, base);
+}
+
+static void fix_job(void* context, int index) {
+    ParallelCheck* check = context;
+    const Job* job = &check->jobs[index];
+    for (int b = job->first; b < job->end; b++) {
+        const BlockResult* block = &check->blocks[b];
+        if (block->base >= 0 && (block->local_slots > 0 || block->use_count > 0)) {
+            fix_slots(&check->snapshot, check->program->children[block->statement], block->base);
+        }
+    }
+}
+
+// -----------------------------------------------------------------
+// Entry point
+// -----------------------------------------------------------------
+
+// Build the snapshot and the list of top-level blocks.
+static int prepare(ParallelCheck* check) {
+    ASTNode* program = check->program;
+    int count = 0;
+    for (int i = 0; i < program->child_count; i++) {
+        count += program->children[i] && program->children[i]->type == AST_BLOCK;
+    }
+    check->blocks = calloc(count ? (size_t)count : 1, sizeof(BlockResult));
+    if (!check->blocks) {
+        return 0;
+    }
+    for (int i = 0; i < program->child_count; i++) {
+        ASTNode* statement = program->children[i];
+        if (!statement) continue;
+        if (statement->type == AST_BLOCK) {
+            check->blocks[check->block_count++].statement = i;
+        } else if (statement->type == AST_VARDECL) {
+            if (!add_global(&check->snapshot, statement->token.lexeme, i)) return 0;
+        } else {
+            note_assignments(&check->snapshot, statement, i);
+        }
+    }
+    return 1;
+}
+
+static void free_check(ParallelCheck* check) {
+    for (int b = 0; b < check->block_count; b++) {
+        free(check->blocks[b].uses);
+    }
+    for (int j = 0; j < check->job_count; j++) {
+        diagnostics_free(&check->jobs[j].diagnostics);
+    }
+    free(check->blocks);
+    free(check->jobs);
+    free(check->snapshot.globals);
+    free(check->snapshot.index);
+}
+
+int analyze_semantics_parallel(ASTNode* ast, DiagnosticList* diagnostics, int* slot_count,
+                               int thread_count) {
+    if (!ast || ast->type != AST_PROGRAM || thread_count < 2) {
+        return analyze_semantics_record(ast, diagnostics, slot_count);
+    }
+    ParallelCheck check = {0};
+    check.program = ast;
+    if (!grow_snapshot(&check.snapshot) || !prepare(&check) ||
+        check.block_count < PARALLEL_CHECK_MIN_BLOCKS) {
+        free_check(&check);
+        return analyze_semantics_record(ast, diagnostics, slot_count);
+    }
+
+    check.job_count = thread_count * PARALLEL_CHECK_JOBS_PER_THREAD;
+    if (check.job_count > check.block_count) check.job_count = check.block_count;
+    check.jobs = calloc((size_t)check.job_count, sizeof(Job));
+    SymbolTable* table = init_symbol_table();
+    if (!check.jobs || !table) {
+        if (table) free_symbol_table(table);
+        free_check(&check);
+        return analyze_semantics_record(ast, diagnostics, slot_count);
+    }
+    for (int j = 0; j < check.job_count; j++) {
+        check.jobs[j].first = (int)((long long)check.block_count * j / check.job_count);
+        check.jobs[j].end = (int)((long long)check.block_count * (j + 1) / check.job_count);
+        for (int b = check.jobs[j].first; b < check.jobs[j].end; b++) {
+            check.blocks[b].job = j;
+        }
+    }
+
+    STATS_START(timer);
+    stats_take(&check.caller);  // A worker may run on this thread
+    thread_pool_run(check.job_count, thread_count, check_job, &check);
+    stats_put(&check.caller);
+    for (int j = 0; j < check.job_count; j++) {
+        stats_put(&check.jobs[j].stats);
+    }
+    int result = merge(&check, table);
+    thread_pool_run(check.job_count, thread_count, fix_job, &check);
+    ast->depth = 0;
+    ast->frame_size = table->slot_count;
+    STATS_STOP(STATS_CHECK, timer);
+
+    diagnostics_append(diagnostics, table->diagnostics.items, table->diagnostics.count);
+    if (slot_count)
+        *slot_count = table->slot_count;
+    free_symbol_table(table);
+    free_check(&check);
+    return result;
+}
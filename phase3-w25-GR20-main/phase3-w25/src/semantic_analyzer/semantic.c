@@ -1,77 +1,131 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include "semantic.h"
 #include "parser.h"
+#include "stats.h"
 
 // ============================
 // Symbol Table Implementation
 // ============================
 
+#define SYMBOL_TABLE_INITIAL_SLOTS 64
+
+// Hash an interned name by its address.
+static unsigned int hash_name(const char* name) {
+    uintptr_t bits = (uintptr_t)name >> 3;
+    return (unsigned int)(bits * 2654435761u);
+}
+
+// Find the slot for `name`: either the slot holding it or the empty slot where it belongs.
+static SymbolSlot* find_slot(const SymbolTable* table, const char* name) {
+    unsigned int i = hash_name(name) & table->slot_mask;
+    while (table->slots[i].name && table->slots[i].name != name) {
+        i = (i + 1) & table->slot_mask;
+    }
+    return &table->slots[i];
+}
+
+// Double the slot array and re-insert every key.
+static int grow_slots(SymbolTable* table) {
+    unsigned int old_count = table->slot_mask + 1;
+    SymbolSlot* old_slots = table->slots;
+    SymbolSlot* slots = (SymbolSlot*)calloc(old_count * 2, sizeof(SymbolSlot));
+    if (!slots)
+        return 0;
+    table->slots = slots;
+    table->slot_mask = old_count * 2 - 1;
+    for (unsigned int i = 0; i < old_count; i++) {
+        if (old_slots[i].name)
+            *find_slot(table, old_slots[i].name) = old_slots[i];
+    }
+    free(old_slots);
+    return 1;
+}
+
 // Create a new symbol table with scope level 0
 SymbolTable* init_symbol_table() {
-    SymbolTable* table = (SymbolTable*)malloc(sizeof(SymbolTable));
+    SymbolTable* table = (SymbolTable*)calloc(1, sizeof(SymbolTable));
     if (table) {
-        table->head = NULL;
+        table->slots = (SymbolSlot*)calloc(SYMBOL_TABLE_INITIAL_SLOTS, sizeof(SymbolSlot));
+        if (!table->slots) {
+            free(table);
+            return NULL;
+        }
+        table->slot_mask = SYMBOL_TABLE_INITIAL_SLOTS - 1;
         table->current_scope = 0;
+        table->out = stdout;
     }
     return table;
 }
 
-// Add a new symbol to the table (in the current scope)
-void add_symbol(SymbolTable* table, const char* name, int type, int line) {
+// Add a new symbol to the table (in the current scope) and give it the next runtime slot.
+// The symbol shadows any same-named symbol from an enclosing scope until its scope exits.
+// Returns NULL if out of memory.
+Symbol* add_symbol(SymbolTable* table, const char* name, int type, int line) {
+    if (table->count == table->capacity) {
+        int capacity = table->capacity ? table->capacity * 2 : 32;
+        Symbol** declared = (Symbol**)realloc(table->declared, capacity * sizeof(Symbol*));
+        if (!declared)
+            return NULL;
+        table->declared = declared;
+        table->capacity = capacity;
+    }
+    if ((table->slot_used + 1) * 2 > table->slot_mask + 1 && !grow_slots(table))
+        return NULL;
     Symbol* symbol = (Symbol*)malloc(sizeof(Symbol));
     if (symbol) {
-        strncpy(symbol->name, name, sizeof(symbol->name));
-        symbol->name[sizeof(symbol->name) - 1] = '\0';
+        symbol->name = name;
         symbol->type = type;
         symbol->scope_level = table->current_scope;
         symbol->line_declared = line;
         symbol->is_initialized = 0;
-        // Insert at the beginning of the list
-        symbol->next = table->head;
-        table->head = symbol;
+        symbol->slot = table->slot_count++;
+        // Push onto the name's shadowing chain and the scope undo stack
+        SymbolSlot* slot = find_slot(table, name);
+        if (!slot->name) {
+            slot->name = name;
+            table->slot_used++;
+        }
+        symbol->next = slot->symbol;
+        slot->symbol = symbol;
+        table->declared[table->count++] = symbol;
     }
+    return symbol;
 }
 
-// Look up a symbol by name across all scopes
+// Look up a symbol by name across all scopes; the innermost declaration wins
 Symbol* lookup_symbol(SymbolTable* table, const char* name) {
-    Symbol* current = table->head;
-    while (current) {
-        if (strcmp(current->name, name) == 0)
-            return current;
-        current = current->next;
-    }
-    return NULL;
+    STATS_COUNT(lookups, 1);
+    Symbol* symbol = find_slot(table, name)->symbol;
+    if (!symbol && table->resolve)
+        symbol = table->resolve(table->resolve_context, name);
+    return symbol;
 }
 
 // Look up a symbol by name only in the current scope
 Symbol* lookup_symbol_current_scope(SymbolTable* table, const char* name) {
-    Symbol* current = table->head;
-    while (current) {
-        if (strcmp(current->name, name) == 0 && current->scope_level == table->current_scope)
-            return current;
-        current = current->next;
-    }
+    Symbol* symbol = lookup_symbol(table, name);
+    if (symbol && symbol->scope_level == table->current_scope)
+        return symbol;
     return NULL;
 }
 
 // Enter a new scope level (e.g., when entering a block)
 void enter_scope(SymbolTable* table) {
     table->current_scope++;
+    STATS_PEAK(peak_scope_depth, table->current_scope);
 }
 
-// Remove all symbols declared in the current scope
+// Remove all symbols declared in the current scope.
+// Inner-scope symbols always sit on top of the undo stack, so only they are visited.
 void remove_symbols_in_current_scope(SymbolTable* table) {
-    Symbol** current = &table->head;
-    while (*current) {
-        if ((*current)->scope_level == table->current_scope) {
-            Symbol* temp = *current;
-            *current = (*current)->next;
-            free(temp);
-        } else {
-            current = &((*current)->next);
-        }
+    while (table->count > 0 &&
+           table->declared[table->count - 1]->scope_level == table->current_scope) {
+        Symbol* symbol = table->declared[--table->count];
+        find_slot(table, symbol->name)->symbol = symbol->next;
+        free(symbol);
     }
 }
 
@@ -83,92 +137,192 @@ void exit_scope(SymbolTable* table) {
 
 // Free the entire symbol table
 void free_symbol_table(SymbolTable* table) {
-    Symbol* current = table->head;
-    while (current) {
-        Symbol* temp = current;
-        current = current->next;
-        free(temp);
-    }
+    for (int i = 0; i < table->count; i++)
+        free(table->declared[i]);
+    free(table->declared);
+    free(table->assigned);
+    free(table->slots);
+    diagnostics_free(&table->diagnostics);
     free(table);
 }
 
-// Dump the contents of the symbol table (for debugging)
+// Dump the contents of the symbol table (for debugging), most recent declaration first
 void dump_symbol_table(SymbolTable* table) {
-    int count = 0;
-    Symbol* current = table->head;
-    while (current) {
-        count++;
-        current = current->next;
-    }
-    printf("== SYMBOL TABLE DUMP ==\n");
-    printf("Total symbols: %d\n\n", count);
-    current = table->head;
+    FILE* out = table->out;
+    fprintf(out, "== SYMBOL TABLE DUMP ==\n");
+    fprintf(out, "Total symbols: %d\n\n", table->count);
     int index = 0;
-    while (current) {
-        printf("Symbol[%d]:\n", index);
-        printf("  Name: %s\n", current->name);
-        printf("  Type: %d\n", current->type);
-        printf("  Scope Level: %d\n", current->scope_level);
-        printf("  Line Declared: %d\n", current->line_declared);
-        printf("  Initialized: %s\n", current->is_initialized ? "Yes" : "No");
-        printf("\n");
-        current = current->next;
+    for (int i = table->count - 1; i >= 0; i--) {
+        Symbol* current = table->declared[i];
+        fprintf(out, "Symbol[%d]:\n", index);
+        fprintf(out, "  Name: %s\n", current->name);
+        fprintf(out, "  Type: %d\n", current->type);
+        fprintf(out, "  Scope Level: %d\n", current->scope_level);
+        fprintf(out, "  Line Declared: %d\n", current->line_declared);
+        fprintf(out, "  Initialized: %s\n", current->is_initialized ? "Yes" : "No");
+        fprintf(out, "\n");
         index++;
     }
-    printf("===================\n");
+    fprintf(out, "===================\n");
 }
 
 // ============================
 // Semantic Error Reporting
 // ============================
 void semantic_error(SemanticErrorType error, const char* name, int line) {
-    printf("Semantic Error at line %d: ", line);
-    switch (error) {
-        case SEM_ERROR_UNDECLARED_VARIABLE:
-            printf("Undeclared variable '%s'\n", name);
-            break;
-        case SEM_ERROR_REDECLARED_VARIABLE:
-            printf("Variable '%s' already declared in this scope\n", name);
-            break;
-        case SEM_ERROR_TYPE_MISMATCH:
-            printf("Type mismatch involving '%s'\n", name);
-            break;
-        case SEM_ERROR_UNINITIALIZED_VARIABLE:
-            printf("Variable '%s' may be used uninitialized\n", name);
-            break;
-        case SEM_ERROR_INVALID_OPERATION:
-            printf("Invalid operation involving '%s'\n", name);
-            break;
-        default:
-            printf("Unknown semantic error with '%s'\n", name);
-    }
+    semantic_error_to(stdout, error, name, line);
+}
+
+// Report a semantic error on the given stream.
+void semantic_error_to(FILE* out, SemanticErrorType error, const char* name, int line) {
+    Diagnostic diagnostic = {DIAGNOSTIC_SEMANTIC, error, line, 0, name ? name : ""};
+    diagnostics_print(&diagnostic, 1, DIAGNOSTICS_TEXT, NULL, out);
+}
+
+// Record a semantic error about `node`'s token.
+static void report(SymbolTable* table, SemanticErrorType error, const char* name, const ASTNode* node) {
+    diagnostics_add(&table->diagnostics, DIAGNOSTIC_SEMANTIC, error, node->token.line,
+                    node->token.column, name);
 }
 
 // ============================
 // Semantic Analysis Functions
 // ============================
 
-// Main semantic analysis function; initializes symbol table and checks the AST
+// Main semantic analysis function; initializes symbol table and checks the AST,
+// printing the errors to stdout
 int analyze_semantics(ASTNode* ast) {
+    return analyze_semantics_to(ast, stdout, 0);
+}
+
+// Check the AST, writing errors (and the final table, if dump_table) to `out`.
+// Each call uses its own symbol table, so concurrent calls are independent.
+int analyze_semantics_to(ASTNode* ast, FILE* out, int dump_table) {
+    return analyze_semantics_slots(ast, out, dump_table, NULL);
+}
+
+// As analyze_semantics_to, also storing in *slot_count how many variable
+// slots the resolved AST uses. Every declaration and use carries its slot
+// and the scope depth it was declared at; the program and every block
+// carry their frame size.
+int analyze_semantics_slots(ASTNode* ast, FILE* out, int dump_table, int* slot_count) {
+    SymbolTable* table = init_symbol_table();
+    if (!table)
+        return 0;
+    table->out = out;
+    int result = check_program(ast, table);
+    diagnostics_print(table->diagnostics.items, table->diagnostics.count, DIAGNOSTICS_TEXT, NULL, out);
+    if (dump_table)
+        dump_symbol_table(table);  // Dump the table (optional for debugging)
+    if (slot_count)
+        *slot_count = table->slot_count;
+    free_symbol_table(table);
+    return result;
+}
+
+// Check the AST without any output, appending its errors to `diagnostics`.
+int analyze_semantics_record(ASTNode* ast, DiagnosticList* diagnostics, int* slot_count) {
     SymbolTable* table = init_symbol_table();
+    if (!table)
+        return 0;
     int result = check_program(ast, table);
-    dump_symbol_table(table);  // Dump the table (optional for debugging)
+    diagnostics_append(diagnostics, table->diagnostics.items, table->diagnostics.count);
+    if (slot_count)
+        *slot_count = table->slot_count;
     free_symbol_table(table);
     return result;
 }
 
+// Definite assignment: a variable may only be read where every path to the
+// read assigns it. For this language's structured control flow the forward
+// dataflow solution falls out of one walk. A loop body might not run (its
+// condition cannot assign anything), so a while leaves the state as it
+// found it; a repeat body always runs once; after an if only the variables
+// both branches assigned are initialized. Marks made inside an if or while
+// body are logged so they can be undone; at the top level nothing is.
+static void mark_initialized(SymbolTable* table, Symbol* symbol) {
+    if (symbol->is_initialized)
+        return;
+    if (table->branch_depth > 0) {
+        if (table->assigned_count == table->assigned_capacity) {
+            int capacity = table->assigned_capacity ? table->assigned_capacity * 2 : 16;
+            Symbol** assigned = (Symbol**)realloc(table->assigned, capacity * sizeof(Symbol*));
+            if (!assigned) {
+                symbol->is_initialized = 1;  // Out of memory: err on the side of no errors
+                return;
+            }
+            table->assigned = assigned;
+            table->assigned_capacity = capacity;
+        }
+        table->assigned[table->assigned_count++] = symbol;
+    }
+    symbol->is_initialized = 1;
+}
+
+// Clear the marks logged in [from, to).
+static void undo_marks(SymbolTable* table, int from, int to) {
+    for (int i = from; i < to; i++)
+        table->assigned[i]->is_initialized = 0;
+}
+
+// Check an if statement: keep the marks that both branches made.
+static int check_if(ASTNode* node, SymbolTable* table) {
+    int valid = 1;
+    if (node->left)
+        valid &= check_condition(node->left, table);
+    table->branch_depth++;
+    int mark = table->assigned_count;
+    if (node->right)
+        valid &= check_statement(node->right, table);
+    int then_end = table->assigned_count;
+    undo_marks(table, mark, then_end);
+    if (node->else_branch)
+        valid &= check_statement(node->else_branch, table);
+    // A then-branch mark the else branch made again is on both paths.
+    int kept = mark;
+    for (int i = mark; i < then_end; i++) {
+        if (table->assigned[i]->is_initialized)
+            table->assigned[kept++] = table->assigned[i];
+    }
+    undo_marks(table, then_end, table->assigned_count);
+    for (int i = mark; i < kept; i++)
+        table->assigned[i]->is_initialized = 1;
+    table->branch_depth--;
+    table->assigned_count = table->branch_depth > 0 ? kept : 0;
+    return valid;
+}
+
+// Check a while statement: the body may not run, so its marks are undone.
+static int check_while(ASTNode* node, SymbolTable* table) {
+    int valid = 1;
+    if (node->left)
+        valid &= check_condition(node->left, table);
+    table->branch_depth++;
+    int mark = table->assigned_count;
+    if (node->right)
+        valid &= check_statement(node->right, table);
+    undo_marks(table, mark, table->assigned_count);
+    table->assigned_count = mark;
+    table->branch_depth--;
+    return valid;
+}
+
 // Check the overall program (assumes AST_PROGRAM as the root)
+// The statements are checked in a loop, so stack depth does not grow
+// with the length of the program.
 int check_program(ASTNode* node, SymbolTable* table) {
     if (!node) return 1;
+    STATS_START(timer);
     int valid = 1;
-    if (node->type == AST_PROGRAM) {
-        if (node->left)
-            valid &= check_statement(node->left, table);
-        if (node->right)
-            valid &= check_program(node->right, table);
+    if (node->type != AST_PROGRAM) {
+        valid = check_statement(node, table);
     } else {
-        valid &= check_statement(node, table);
+        for (int i = 0; i < node->child_count; i++)
+            valid &= check_statement(node->children[i], table);
+        node->depth = 0;
+        node->frame_size = table->slot_count;
     }
+    STATS_STOP(STATS_CHECK, timer);
     return valid;
 }
 
@@ -188,18 +342,17 @@ int check_statement(ASTNode* node, SymbolTable* table) {
             break;
         case AST_IF:
             // For if: left is condition; right is then-branch; else_branch (if not NULL) is the else-part.
-            if (node->left)
-                valid &= check_condition(node->left, table);
-            if (node->right)
-                valid &= check_statement(node->right, table);
-            if (node->else_branch)
-                valid &= check_statement(node->else_branch, table);
+            valid = check_if(node, table);
             break;
         case AST_WHILE:
+            valid = check_while(node, table);
+            break;
+        case AST_REPEAT:
+            // For repeat: left is the body; right is the until-condition.
             if (node->left)
-                valid &= check_condition(node->left, table);
+                valid &= check_statement(node->left, table);
             if (node->right)
-                valid &= check_statement(node->right, table);
+                valid &= check_condition(node->right, table);
             break;
         case AST_PRINT:
             if (node->left)
@@ -221,11 +374,15 @@ int check_declaration(ASTNode* node, SymbolTable* table) {
     // Ensure the variable is not already declared in the same scope
     Symbol* existing = lookup_symbol_current_scope(table, name);
     if (existing) {
-        semantic_error(SEM_ERROR_REDECLARED_VARIABLE, name, node->token.line);
+        report(table, SEM_ERROR_REDECLARED_VARIABLE, name, node);
         return 0;
     }
     // Add the new variable; adjust the type (e.g., TOKEN_INT) as needed
-    add_symbol(table, name, TOKEN_INT, node->token.line);
+    Symbol* symbol = add_symbol(table, name, TOKEN_INT, node->token.line);
+    if (!symbol)
+        return 0;
+    node->slot = symbol->slot;
+    node->depth = symbol->scope_level;
     return 1;
 }
 
@@ -236,12 +393,14 @@ int check_assignment(ASTNode* node, SymbolTable* table) {
     const char* name = node->left->token.lexeme;
     Symbol* symbol = lookup_symbol(table, name);
     if (!symbol) {
-        semantic_error(SEM_ERROR_UNDECLARED_VARIABLE, name, node->token.line);
+        report(table, SEM_ERROR_UNDECLARED_VARIABLE, name, node);
         return 0;
     }
+    node->left->slot = symbol->slot;
+    node->left->depth = symbol->scope_level;
     int expr_valid = check_expression(node->right, table);
     if (expr_valid) {
-        symbol->is_initialized = 1;
+        mark_initialized(table, symbol);
     }
     return expr_valid;
 }
@@ -258,10 +417,13 @@ int check_expression(ASTNode* node, SymbolTable* table) {
             {
                 Symbol* symbol = lookup_symbol(table, node->token.lexeme);
                 if (!symbol) {
-                    semantic_error(SEM_ERROR_UNDECLARED_VARIABLE, node->token.lexeme, node->token.line);
+                    report(table, SEM_ERROR_UNDECLARED_VARIABLE, node->token.lexeme, node);
                     valid = 0;
-                } else if (!symbol->is_initialized) {
-                    semantic_error(SEM_ERROR_UNINITIALIZED_VARIABLE, node->token.lexeme, node->token.line);
+                } else {
+                    node->slot = symbol->slot;
+                    node->depth = symbol->scope_level;
+                    if (!symbol->is_initialized)
+                        report(table, SEM_ERROR_UNINITIALIZED_VARIABLE, node->token.lexeme, node);
                 }
             }
             break;
@@ -279,13 +441,26 @@ int check_expression(ASTNode* node, SymbolTable* table) {
 }
 
 // Check a block of statements (handles scope entry/exit)
-// Assumes a block node where the left child is the first statement and the right child continues the block.
+// All statements of the block share one scope. Slots are handed out in
+// declaration order, so the block's variables (and those of its nested
+// blocks) take the frame_size slots that follow the ones before it.
 int check_block(ASTNode* node, SymbolTable* table) {
     if (!node) return 1;
+    int first_slot = table->slot_count;
+    int mark = table->assigned_count;
     enter_scope(table);
     int valid = 1;
-    valid &= check_statement(node->left, table);
-    valid &= check_block(node->right, table);
+    for (int i = 0; i < node->child_count; i++)
+        valid &= check_statement(node->children[i], table);
+    node->depth = table->current_scope;
+    node->frame_size = table->slot_count - first_slot;
+    // The block's own symbols are freed on exit; drop their marks first.
+    int kept = mark;
+    for (int i = mark; i < table->assigned_count; i++) {
+        if (table->assigned[i]->scope_level != table->current_scope)
+            table->assigned[kept++] = table->assigned[i];
+    }
+    table->assigned_count = kept;
     exit_scope(table);
     return valid;
 }
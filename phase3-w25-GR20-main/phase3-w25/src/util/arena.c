@@ -0,0 +1,78 @@
+#include <stdlib.h>
+#include "../../include/arena.h"
+#include "../../include/stats.h"
+
+#define ARENA_MIN_CHUNK (4 * 1024)
+#define ARENA_MAX_CHUNK (1024 * 1024)
+#define ARENA_ALIGN     (sizeof(max_align_t))
+
+static size_t align_up(size_t n) {
+    return (n + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+}
+
+// Allocate a fresh chunk of at least `size` bytes and make it the head.
+static ArenaChunk* arena_grow(Arena* arena, size_t size) {
+    size_t capacity = arena->next_chunk_size ? arena->next_chunk_size : ARENA_MIN_CHUNK;
+    if (capacity < size) {
+        capacity = align_up(size);
+    }
+    ArenaChunk* chunk = malloc(sizeof(ArenaChunk) + capacity);
+    if (!chunk) {
+        return NULL;
+    }
+    chunk->next = arena->head;
+    chunk->used = 0;
+    chunk->capacity = capacity;
+    arena->head = chunk;
+    if (arena->next_chunk_size < ARENA_MAX_CHUNK) {
+        arena->next_chunk_size = capacity < ARENA_MIN_CHUNK ? ARENA_MIN_CHUNK * 2 : capacity * 2;
+        if (arena->next_chunk_size > ARENA_MAX_CHUNK) {
+            arena->next_chunk_size = ARENA_MAX_CHUNK;
+        }
+    }
+    return chunk;
+}
+
+// Hand out `size` bytes, aligned for any object type. Returns NULL on out-of-memory.
+void* arena_alloc(Arena* arena, size_t size) {
+    size = align_up(size ? size : 1);
+    STATS_COUNT(bytes, (long long)size);
+    ArenaChunk* chunk = arena->head;
+    if (!chunk || chunk->capacity - chunk->used < size) {
+        chunk = arena_grow(arena, size);
+        if (!chunk) {
+            return NULL;
+        }
+    }
+    void* ptr = chunk->data + chunk->used;
+    chunk->used += size;
+    return ptr;
+}
+
+// Free every chunk except the most recent (largest) one, which is emptied for reuse.
+void arena_reset(Arena* arena) {
+    ArenaChunk* keep = arena->head;
+    if (!keep) {
+        return;
+    }
+    ArenaChunk* chunk = keep->next;
+    while (chunk) {
+        ArenaChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    keep->next = NULL;
+    keep->used = 0;
+}
+
+// Release all memory owned by the arena; it may be reused afterwards.
+void arena_destroy(Arena* arena) {
+    ArenaChunk* chunk = arena->head;
+    while (chunk) {
+        ArenaChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    arena->head = NULL;
+    arena->next_chunk_size = 0;
+}
@@ -0,0 +1,243 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/diagnostics.h"
+#include "../../include/tokens.h"
+#include "../../include/parser.h"
+#include "../../include/semantic.h"
+
+// -----------------------------------------------------------------
+// Message tables. In a template, %L stands for the line and %S for the
+// lexeme.
+// -----------------------------------------------------------------
+
+typedef struct {
+    const char* name;         // Code as it appears in JSON
+    const char* text;         // Message template
+} MessageInfo;
+
+static MessageInfo lexical_message(int code) {
+    switch (code) {
+        case ERROR_INVALID_CHAR:          return (MessageInfo){"invalid_char", "Lexical Error at line %L: Invalid character '%S'"};
+        case ERROR_INVALID_NUMBER:        return (MessageInfo){"invalid_number", "Lexical Error at line %L: Invalid number format"};
+        case ERROR_CONSECUTIVE_OPERATORS: return (MessageInfo){"consecutive_operators", "Lexical Error at line %L: Consecutive operators not allowed"};
+        case ERROR_INVALID_IDENTIFIER:    return (MessageInfo){"invalid_identifier", "Lexical Error at line %L: Invalid identifier"};
+        case ERROR_UNEXPECTED_TOKEN:      return (MessageInfo){"unexpected_token", "Lexical Error at line %L: Unexpected token '%S'"};
+        default:                          return (MessageInfo){"unknown", "Lexical Error at line %L: Unknown error"};
+    }
+}
+
+static MessageInfo syntax_message(int code) {
+    switch (code) {
+        case PARSE_ERROR_UNEXPECTED_TOKEN:     return (MessageInfo){"unexpected_token", "Parse Error at line %L: Unexpected token '%S'"};
+        case PARSE_ERROR_MISSING_SEMICOLON:    return (MessageInfo){"missing_semicolon", "Parse Error at line %L: Missing semicolon after '%S'"};
+        case PARSE_ERROR_MISSING_IDENTIFIER:   return (MessageInfo){"missing_identifier", "Parse Error at line %L: Expected identifier after '%S'"};
+        case PARSE_ERROR_MISSING_EQUALS:       return (MessageInfo){"missing_equals", "Parse Error at line %L: Expected '=' after '%S'"};
+        case PARSE_ERROR_INVALID_EXPRESSION:   return (MessageInfo){"invalid_expression", "Parse Error at line %L: Invalid expression after '%S'"};
+        case PARSE_ERROR_MISSING_LPAREN:       return (MessageInfo){"missing_lparen", "Parse Error at line %L: Missing '(' after '%S'"};
+        case PARSE_ERROR_MISSING_RPAREN:       return (MessageInfo){"missing_rparen", "Parse Error at line %L: Missing ')' after '%S'"};
+        case PARSE_ERROR_MISSING_CONDITION:    return (MessageInfo){"missing_condition", "Parse Error at line %L: Missing condition after '%S'"};
+        case PARSE_ERROR_MISSING_BLOCK:        return (MessageInfo){"missing_block", "Parse Error at line %L: Missing block braces after '%S'"};
+        case PARSE_ERROR_INVALID_OPERATOR:     return (MessageInfo){"invalid_operator", "Parse Error at line %L: Invalid operator '%S'"};
+        case PARSE_ERROR_FUNCTION_CALL:        return (MessageInfo){"function_call", "Parse Error at line %L: Function call error near '%S'"};
+        case PARSE_ERROR_NESTING_TOO_DEEP:     return (MessageInfo){"nesting_too_deep", "Parse Error at line %L: Nesting too deep at '%S'"};
+        case PARSE_ERROR_EXPECTED_PRIMARY:     return (MessageInfo){"expected_primary", "Syntax Error: Expected primary expression at line %L"};
+        case PARSE_ERROR_UNEXPECTED_STATEMENT: return (MessageInfo){"unexpected_statement", "Syntax Error: Unexpected token '%S'"};
+        default:                               return (MessageInfo){"unknown", "Parse Error at line %L: Unknown error"};
+    }
+}
+
+static MessageInfo semantic_message(int code) {
+    switch (code) {
+        case SEM_ERROR_UNDECLARED_VARIABLE:    return (MessageInfo){"undeclared_variable", "Semantic Error at line %L: Undeclared variable '%S'"};
+        case SEM_ERROR_REDECLARED_VARIABLE:    return (MessageInfo){"redeclared_variable", "Semantic Error at line %L: Variable '%S' already declared in this scope"};
+        case SEM_ERROR_TYPE_MISMATCH:          return (MessageInfo){"type_mismatch", "Semantic Error at line %L: Type mismatch involving '%S'"};
+        case SEM_ERROR_UNINITIALIZED_VARIABLE: return (MessageInfo){"uninitialized_variable", "Semantic Error at line %L: Variable '%S' may be used uninitialized"};
+        case SEM_ERROR_INVALID_OPERATION:      return (MessageInfo){"invalid_operation", "Semantic Error at line %L: Invalid operation involving '%S'"};
+        default:                               return (MessageInfo){"unknown", "Semantic Error at line %L: Unknown semantic error with '%S'"};
+    }
+}
+
+static MessageInfo message_info(const Diagnostic* diagnostic) {
+    switch (diagnostic->phase) {
+        case DIAGNOSTIC_LEXICAL: return lexical_message(diagnostic->code);
+        case DIAGNOSTIC_SYNTAX:  return syntax_message(diagnostic->code);
+        default:                 return semantic_message(diagnostic->code);
+    }
+}
+
+static const char* phase_name(DiagnosticPhase phase) {
+    switch (phase) {
+        case DIAGNOSTIC_LEXICAL: return "lexical";
+        case DIAGNOSTIC_SYNTAX:  return "syntax";
+        default:                 return "semantic";
+    }
+}
+
+// -----------------------------------------------------------------
+// Lists
+// -----------------------------------------------------------------
+
+static int reserve(DiagnosticList* list, int count) {
+    if (list->count + count <= list->capacity) {
+        return 1;
+    }
+    int capacity = list->capacity ? list->capacity : 16;
+    while (capacity < list->count + count) {
+        capacity *= 2;
+    }
+    Diagnostic* items = realloc(list->items, (size_t)capacity * sizeof(Diagnostic));
+    if (!items) {
+        return 0;
+    }
+    list->items = items;
+    list->capacity = capacity;
+    return 1;
+}
+
+void diagnostics_add(DiagnosticList* list, DiagnosticPhase phase, int code, int line, int column,
+                     const char* lexeme) {
+    if (!reserve(list, 1)) {
+        list->dropped++;
+        return;
+    }
+    Diagnostic* diagnostic = &list->items[list->count++];
+    diagnostic->phase = phase;
+    diagnostic->code = code;
+    diagnostic->line = line;
+    diagnostic->column = column;
+    diagnostic->lexeme = lexeme ? lexeme : "";
+}
+
+void diagnostics_append(DiagnosticList* list, const Diagnostic* items, int count) {
+    if (count <= 0) {
+        return;
+    }
+    if (!reserve(list, count)) {
+        list->dropped += count;
+        return;
+    }
+    memcpy(list->items + list->count, items, (size_t)count * sizeof(Diagnostic));
+    list->count += count;
+}
+
+void diagnostics_clear(DiagnosticList* list) {
+    list->count = 0;
+    list->dropped = 0;
+}
+
+void diagnostics_free(DiagnosticList* list) {
+    free(list->items);
+    memset(list, 0, sizeof(*list));
+}
+
+// -----------------------------------------------------------------
+// Formatters
+// -----------------------------------------------------------------
+
+// Destination of an expanded template: a stream (optionally as the
+// inside of a JSON string) or a bounded buffer.
+typedef struct {
+    FILE* out;                // NULL = write to buffer
+    int json;
+    char* buffer;
+    size_t size;
+    size_t length;            // Bytes produced so far (even past size)
+} Writer;
+
+// Write `text` as the inside of a JSON string. Bytes outside printable
+// ASCII are escaped as the code points of the same value.
+static void put_json_text(const char* text, size_t length, FILE* out) {
+    for (const unsigned char* p = (const unsigned char*)text; p < (const unsigned char*)text + length; p++) {
+        if (*p == '"' || *p == '\\') {
+            fputc('\\', out);
+            fputc(*p, out);
+        } else if (*p < 0x20 || *p >= 0x7F) {
+            fprintf(out, "\\u%04x", *p);
+        } else {
+            fputc(*p, out);
+        }
+    }
+}
+
+static void put(Writer* writer, const char* text, size_t length) {
+    if (writer->out && writer->json) {
+        put_json_text(text, length, writer->out);
+    } else if (writer->out) {
+        fwrite(text, 1, length, writer->out);
+    } else if (writer->length < writer->size) {
+        size_t room = writer->size - writer->length;
+        memcpy(writer->buffer + writer->length, text, length < room ? length : room);
+    }
+    writer->length += length;
+}
+
+static void expand(Writer* writer, const char* text, const Diagnostic* diagnostic) {
+    char line[16];
+    while (*text) {
+        const char* mark = strchr(text, '%');
+        if (!mark) {
+            put(writer, text, strlen(text));
+            return;
+        }
+        put(writer, text, (size_t)(mark - text));
+        if (mark[1] == 'L') {
+            put(writer, line, (size_t)snprintf(line, sizeof(line), "%d", diagnostic->line));
+        } else if (mark[1] == 'S') {
+            put(writer, diagnostic->lexeme, strlen(diagnostic->lexeme));
+        }
+        text = mark + 2;
+    }
+}
+
+int diagnostics_message(const Diagnostic* diagnostic, char* buffer, size_t size) {
+    Writer writer = {NULL, 0, buffer, size, 0};
+    expand(&writer, message_info(diagnostic).text, diagnostic);
+    if (size > 0) {
+        buffer[writer.length < size ? writer.length : size - 1] = '\0';
+    }
+    return (int)writer.length;
+}
+
+static void print_json(const Diagnostic* diagnostic, const char* file, FILE* out) {
+    MessageInfo info = message_info(diagnostic);
+    Writer writer = {out, 1, NULL, 0, 0};
+    fputc('{', out);
+    if (file) {
+        fputs("\"file\":\"", out);
+        put(&writer, file, strlen(file));
+        fputs("\",", out);
+    }
+    fprintf(out, "\"phase\":\"%s\",\"code\":\"%s\",\"line\":%d,\"column\":%d,\"lexeme\":\"",
+            phase_name(diagnostic->phase), info.name, diagnostic->line, diagnostic->column);
+    put(&writer, diagnostic->lexeme, strlen(diagnostic->lexeme));
+    fputs("\",\"message\":\"", out);
+    expand(&writer, info.text, diagnostic);
+    fputs("\"}\n", out);
+}
+
+void diagnostics_print(const Diagnostic* items, int count, DiagnosticFormat format,
+                       const char* file, FILE* out) {
+    Writer writer = {out, 0, NULL, 0, 0};
+    for (int i = 0; i < count && format != DIAGNOSTICS_QUIET; i++) {
+        if (format == DIAGNOSTICS_JSON) {
+            print_json(&items[i], file, out);
+        } else {
+            expand(&writer, message_info(&items[i]).text, &items[i]);
+            fputc('\n', out);
+        }
+    }
+}
+
+int diagnostics_format_from_name(const char* name, DiagnosticFormat* format) {
+    if (strcmp(name, "text") == 0) {
+        *format = DIAGNOSTICS_TEXT;
+    } else if (strcmp(name, "json") == 0) {
+        *format = DIAGNOSTICS_JSON;
+    } else if (strcmp(name, "quiet") == 0) {
+        *format = DIAGNOSTICS_QUIET;
+    } else {
+        return 0;
+    }
+    return 1;
+}
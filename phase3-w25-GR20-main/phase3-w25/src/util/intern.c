@@ -0,0 +1,102 @@
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/intern.h"
+
+#define INTERN_INITIAL_SLOTS 256
+
+// FNV-1a over the raw bytes.
+static unsigned int hash_bytes(const char* text, size_t length) {
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)text[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Start with an empty table; the index is allocated on first use.
+void intern_init(InternTable* table) {
+    memset(table, 0, sizeof(*table));
+}
+
+// Double the slot index and re-insert every entry.
+static int grow_slots(InternTable* table) {
+    unsigned int slot_count = table->slots ? (table->slot_mask + 1) * 2 : INTERN_INITIAL_SLOTS;
+    unsigned int* slots = calloc(slot_count, sizeof(unsigned int));
+    if (!slots) {
+        return 0;
+    }
+    unsigned int mask = slot_count - 1;
+    for (unsigned int id = 0; id < table->count; id++) {
+        unsigned int i = table->entries[id].hash & mask;
+        while (slots[i]) {
+            i = (i + 1) & mask;
+        }
+        slots[i] = id + 1;
+    }
+    free(table->slots);
+    table->slots = slots;
+    table->slot_mask = mask;
+    return 1;
+}
+
+// Return the ID of `text[0..length)`, adding it to the table if it is new.
+// Returns (unsigned int)-1 if memory runs out.
+unsigned int intern(InternTable* table, const char* text, size_t length) {
+    if (!table->slots && !grow_slots(table)) {
+        return (unsigned int)-1;
+    }
+    unsigned int hash = hash_bytes(text, length);
+    unsigned int i = hash & table->slot_mask;
+    while (table->slots[i]) {
+        InternEntry* entry = &table->entries[table->slots[i] - 1];
+        if (entry->hash == hash && entry->length == length &&
+            memcmp(entry->text, text, length) == 0) {
+            return table->slots[i] - 1;
+        }
+        i = (i + 1) & table->slot_mask;
+    }
+
+    // Not present: copy the bytes into the arena and record a new entry.
+    if (table->count == table->capacity) {
+        unsigned int capacity = table->capacity ? table->capacity * 2 : 64;
+        InternEntry* entries = realloc(table->entries, capacity * sizeof(InternEntry));
+        if (!entries) {
+            return (unsigned int)-1;
+        }
+        table->entries = entries;
+        table->capacity = capacity;
+    }
+    char* copy = arena_alloc(&table->storage, length + 1);
+    if (!copy) {
+        return (unsigned int)-1;
+    }
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+
+    unsigned int id = table->count++;
+    table->entries[id].text = copy;
+    table->entries[id].length = (unsigned int)length;
+    table->entries[id].hash = hash;
+    table->entries[id].value = 0;
+    table->slots[i] = id + 1;
+
+    // Keep the load factor at or below one half.
+    if (table->count * 2 > table->slot_mask + 1) {
+        grow_slots(table);
+    }
+    return id;
+}
+
+// Look up the text for an ID previously returned by intern().
+const char* intern_string(const InternTable* table, unsigned int id) {
+    return id < table->count ? table->entries[id].text : NULL;
+}
+
+// Release every interned string and the index.
+void intern_free(InternTable* table) {
+    arena_destroy(&table->storage);
+    free(table->entries);
+    free(table->slots);
+    memset(table, 0, sizeof(*table));
+}
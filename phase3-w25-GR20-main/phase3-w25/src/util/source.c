@@ -0,0 +1,149 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/source.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SOURCE_HAVE_MMAP 1
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// Read a whole file into a NUL-terminated heap buffer (caller frees).
+char* read_file(const char* filename) {
+    FILE *file = fopen(filename, "rb");  // Open in binary mode
+    if (!file) {
+        perror("Error opening file");
+        return NULL;
+    }
+    fseek(file, 0L, SEEK_END);
+    long size = ftell(file);
+    rewind(file);
+    if (size < 0) {
+        fclose(file);
+        perror("ftell failed");
+        return NULL;
+    }
+    char *buffer = (char *)malloc(size + 1);
+    if (!buffer) {
+        fclose(file);
+        perror("Memory allocation failed");
+        return NULL;
+    }
+    size_t bytesRead = fread(buffer, 1, size, file);
+    buffer[bytesRead] = '\0';
+    fclose(file);
+    return buffer;
+}
+
+#ifdef SOURCE_HAVE_MMAP
+// Map the file read-only. The lexer needs a '\0' after the text; the kernel
+// zero-fills the rest of the last page, so that only works when the size is
+// not an exact multiple of the page size. Returns 0 to request the buffered path.
+static int map_file(SourceFile* source, const char* filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return 0;
+    }
+    struct stat info;
+    long page = sysconf(_SC_PAGESIZE);
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0 ||
+        page <= 0 || info.st_size % page == 0) {
+        close(fd);
+        return 0;
+    }
+    void* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return 0;
+    }
+#ifdef MADV_SEQUENTIAL
+    madvise(data, (size_t)info.st_size, MADV_SEQUENTIAL);
+#endif
+    source->data = data;
+    source->size = (size_t)info.st_size;
+    source->mapped = 1;
+    source->buffer = NULL;
+    return 1;
+}
+#endif
+
+// Load a source file, memory-mapping it where the platform allows and
+// falling back to read_file otherwise. No copy or rewrite of the text is made
+// on the mapped path; the lexer treats '\r' as whitespace itself.
+int source_open(SourceFile* source, const char* filename) {
+#ifdef SOURCE_HAVE_MMAP
+    if (map_file(source, filename)) {
+        return 1;
+    }
+#endif
+    char* buffer = read_file(filename);
+    if (!buffer) {
+        return 0;
+    }
+    source->data = buffer;
+    source->size = strlen(buffer);
+    source->mapped = 0;
+    source->buffer = buffer;
+    return 1;
+}
+
+// Load any file (including binary data and exact page multiples) without
+// the '\0' guarantee, mapping it where possible. Failures are silent so callers
+// can probe for optional files such as cache entries.
+int source_open_binary(SourceFile* source, const char* filename) {
+#ifdef SOURCE_HAVE_MMAP
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return 0;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        void* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            close(fd);
+            source->data = data;
+            source->size = (size_t)info.st_size;
+            source->mapped = 1;
+            source->buffer = NULL;
+            return 1;
+        }
+    }
+    close(fd);
+#endif
+    FILE* file = fopen(filename, "rb");
+    if (!file) {
+        return 0;
+    }
+    fseek(file, 0L, SEEK_END);
+    long size = ftell(file);
+    rewind(file);
+    char* buffer = size >= 0 ? (char*)malloc((size_t)size + 1) : NULL;
+    if (!buffer || fread(buffer, 1, (size_t)size, file) != (size_t)size) {
+        free(buffer);
+        fclose(file);
+        return 0;
+    }
+    fclose(file);
+    buffer[size] = '\0';
+    source->data = buffer;
+    source->size = (size_t)size;
+    source->mapped = 0;
+    source->buffer = buffer;
+    return 1;
+}
+
+void source_close(SourceFile* source) {
+#ifdef SOURCE_HAVE_MMAP
+    if (source->mapped) {
+        munmap((void*)source->data, source->size);
+    }
+#endif
+    free(source->buffer);
+    source->data = NULL;
+    source->size = 0;
+    source->mapped = 0;
+    source->buffer = NULL;
+}
@@ -0,0 +1,69 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include "../../include/spsc_ring.h"
+
+// Busy-wait iterations before a waiting side starts yielding its CPU.
+#define SPSC_SPIN_LIMIT 64
+
+// Round `capacity` up to a power of two (at least 2, so the consumer can
+// hold one element and look at the next).
+int spsc_ring_init(SpscRing* ring, size_t element_size, size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) {
+        size *= 2;
+    }
+    ring->slots = malloc(size * element_size);
+    if (!ring->slots) {
+        return 0;
+    }
+    ring->element_size = element_size;
+    ring->mask = size - 1;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->closed, 0);
+    return 1;
+}
+
+void spsc_ring_destroy(SpscRing* ring) {
+    free(ring->slots);
+    ring->slots = NULL;
+}
+
+static void wait_a_little(int* spins) {
+    if (++*spins > SPSC_SPIN_LIMIT) {
+        sched_yield();
+    }
+}
+
+void spsc_ring_push(SpscRing* ring, const void* element) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    int spins = 0;
+    while (tail - atomic_load_explicit(&ring->head, memory_order_acquire) > ring->mask) {
+        wait_a_little(&spins);
+    }
+    memcpy(ring->slots + (tail & ring->mask) * ring->element_size, element, ring->element_size);
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+}
+
+void spsc_ring_close(SpscRing* ring) {
+    atomic_store_explicit(&ring->closed, 1, memory_order_release);
+}
+
+// `closed` is set after the last push, so once it reads 1 the tail it
+// orders is final: re-reading tail then tells "not yet" from "never".
+const void* spsc_ring_get(SpscRing* ring, size_t index) {
+    int spins = 0;
+    while (index >= atomic_load_explicit(&ring->tail, memory_order_acquire)) {
+        if (atomic_load_explicit(&ring->closed, memory_order_acquire) &&
+            index >= atomic_load_explicit(&ring->tail, memory_order_acquire)) {
+            return NULL;
+        }
+        wait_a_little(&spins);
+    }
+    return ring->slots + (index & ring->mask) * ring->element_size;
+}
+
+void spsc_ring_release(SpscRing* ring, size_t index) {
+    atomic_store_explicit(&ring->head, index, memory_order_release);
+}
@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "../../include/stats.h"
+
+#if FRONTEND_STATS
+_Thread_local FrontendStats stats_thread;
+#endif
+
+static const char* const phase_names[STATS_PHASE_COUNT] = {
+    "lex", "parse", "check", "fold", "bytecode", "run"
+};
+
+double stats_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void stats_add(FrontendStats* into, const FrontendStats* from) {
+    for (int i = 0; i < STATS_PHASE_COUNT; i++) {
+        into->seconds[i] += from->seconds[i];
+    }
+    into->tokens += from->tokens;
+    into->nodes += from->nodes;
+    into->bytes += from->bytes;
+    into->lookups += from->lookups;
+    if (from->peak_scope_depth > into->peak_scope_depth) {
+        into->peak_scope_depth = from->peak_scope_depth;
+    }
+}
+
+void stats_take(FrontendStats* into) {
+#if FRONTEND_STATS
+    if (into) {
+        stats_add(into, &stats_thread);
+    }
+    memset(&stats_thread, 0, sizeof(stats_thread));
+#else
+    (void)into;
+#endif
+}
+
+void stats_put(const FrontendStats* from) {
+#if FRONTEND_STATS
+    stats_add(&stats_thread, from);
+#else
+    (void)from;
+#endif
+}
+
+void stats_print(const FrontendStats* stats, int json, FILE* out) {
+    if (!FRONTEND_STATS) {
+        fputs(json ? "{\"enabled\":false}\n" : "Statistics: not compiled in (FRONTEND_STATS=OFF)\n", out);
+        return;
+    }
+    if (json) {
+        fputs("{\"enabled\":true,\"seconds\":{", out);
+        for (int i = 0; i < STATS_PHASE_COUNT; i++) {
+            fprintf(out, "%s\"%s\":%.6f", i ? "," : "", phase_names[i], stats->seconds[i]);
+        }
+        fprintf(out, "},\"tokens\":%lld,\"nodes\":%lld,\"bytes\":%lld,\"lookups\":%lld,"
+                     "\"peak_scope_depth\":%d}\n",
+                stats->tokens, stats->nodes, stats->bytes, stats->lookups, stats->peak_scope_depth);
+        return;
+    }
+    fputs("Statistics (phase times are summed over threads):\n", out);
+    for (int i = 0; i < STATS_PHASE_COUNT; i++) {
+        fprintf(out, "  %-18s %10.6f s\n", phase_names[i], stats->seconds[i]);
+    }
+    fprintf(out, "  %-18s %10lld\n", "tokens lexed", stats->tokens);
+    fprintf(out, "  %-18s %10lld\n", "AST nodes", stats->nodes);
+    fprintf(out, "  %-18s %10lld\n", "arena bytes", stats->bytes);
+    fprintf(out, "  %-18s %10lld\n", "symbol lookups", stats->lookups);
+    fprintf(out, "  %-18s %10d\n", "peak scope depth", stats->peak_scope_depth);
+}
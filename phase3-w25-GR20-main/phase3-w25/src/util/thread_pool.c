@@ -0,0 +1,125 @@
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "../../include/thread_pool.h"
+
+// A worker's pending jobs: the contiguous range [head, tail).
+// The owner takes from the head; thieves take from the tail.
+typedef struct {
+    pthread_mutex_t lock;
+    int head;
+    int tail;
+} WorkQueue;
+
+typedef struct {
+    WorkQueue* queues;
+    int worker_count;
+    ThreadPoolJob job;
+    void* context;
+} Pool;
+
+typedef struct {
+    Pool* pool;
+    int id;
+    pthread_t thread;
+} Worker;
+
+// Pop the next job from the worker's own queue.
+static int take_own(WorkQueue* queue, int* job) {
+    int found = 0;
+    pthread_mutex_lock(&queue->lock);
+    if (queue->head < queue->tail) {
+        *job = queue->head++;
+        found = 1;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return found;
+}
+
+// Move half of some other worker's remaining jobs into our (empty) queue
+// and return the first of them.
+static int steal(Pool* pool, int self, int* job) {
+    for (int k = 1; k < pool->worker_count; k++) {
+        WorkQueue* victim = &pool->queues[(self + k) % pool->worker_count];
+        pthread_mutex_lock(&victim->lock);
+        int remaining = victim->tail - victim->head;
+        if (remaining <= 0) {
+            pthread_mutex_unlock(&victim->lock);
+            continue;
+        }
+        int start = victim->tail - (remaining + 1) / 2;
+        int end = victim->tail;
+        victim->tail = start;
+        pthread_mutex_unlock(&victim->lock);
+
+        WorkQueue* own = &pool->queues[self];
+        pthread_mutex_lock(&own->lock);
+        own->head = start + 1;
+        own->tail = end;
+        pthread_mutex_unlock(&own->lock);
+        *job = start;
+        return 1;
+    }
+    return 0;
+}
+
+static void* worker_main(void* arg) {
+    Worker* worker = arg;
+    Pool* pool = worker->pool;
+    int job;
+    while (take_own(&pool->queues[worker->id], &job) || steal(pool, worker->id, &job)) {
+        pool->job(pool->context, job);
+    }
+    return NULL;
+}
+
+// Run every job and return once all have finished; the calling thread acts
+// as worker 0. Returns 0 if the pool could not be set up.
+int thread_pool_run(int job_count, int thread_count, ThreadPoolJob job, void* context) {
+    if (thread_count < 1) thread_count = 1;
+    if (thread_count > job_count) thread_count = job_count > 0 ? job_count : 1;
+
+    Pool pool = {NULL, thread_count, job, context};
+    Worker* workers = calloc(thread_count, sizeof(Worker));
+    pool.queues = calloc(thread_count, sizeof(WorkQueue));
+    if (!workers || !pool.queues) {
+        free(workers);
+        free(pool.queues);
+        return 0;
+    }
+    for (int i = 0; i < thread_count; i++) {
+        pthread_mutex_init(&pool.queues[i].lock, NULL);
+        pool.queues[i].head = (int)((long long)job_count * i / thread_count);
+        pool.queues[i].tail = (int)((long long)job_count * (i + 1) / thread_count);
+        workers[i].pool = &pool;
+        workers[i].id = i;
+    }
+
+    int started = 1;
+    for (int i = 1; i < thread_count; i++) {
+        if (pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]) != 0) {
+            break;  // Remaining queues are drained by stealing
+        }
+        started++;
+    }
+    worker_main(&workers[0]);
+    for (int i = 1; i < started; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+
+    for (int i = 0; i < thread_count; i++) {
+        pthread_mutex_destroy(&pool.queues[i].lock);
+    }
+    free(pool.queues);
+    free(workers);
+    return 1;
+}
+
+int thread_pool_default_threads(void) {
+#ifdef _SC_NPROCESSORS_ONLN
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+#else
+    return 1;
+#endif
+}